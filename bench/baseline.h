@@ -0,0 +1,252 @@
+#ifndef HASHMAP_BENCH_BASELINE_H
+#define HASHMAP_BENCH_BASELINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+    struct probe_stats {
+        double mean_displacement{0};
+        size_t max_displacement{0};
+        size_t longest_cluster{0};
+    };
+
+    template<class TKey,
+            class TValue,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>>
+    class linear_probing_map {
+        struct slot {
+            std::pair<TKey, TValue> value;
+            bool used{false};
+        };
+
+        using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+
+        template<typename TSlot, typename TItem>
+        class linear_probing_iterator;
+
+    public:
+        using key_type = TKey;
+        using mapped_type = TValue;
+        using value_type = std::pair<TKey, TValue>;
+        using size_type = size_t;
+
+        using iterator = linear_probing_iterator<slot, value_type>;
+        using const_iterator = linear_probing_iterator<const slot, const value_type>;
+
+    private:
+        static constexpr const size_type kMinCapacity = 8;
+
+        KeyHash hash_;
+        KeyEqual equal_;
+        std::vector<slot, slot_allocator> slots_;
+        size_type size_{0};
+        float max_load_factor_{0.5f};
+
+    private:
+        size_type _mask() const {
+            return slots_.size() - 1;
+        }
+
+        size_type _find_index(const key_type &key) const {
+            if (slots_.empty()) {
+                return slots_.size();
+            }
+            size_type index = hash_(key) & _mask();
+            while (slots_[index].used) {
+                if (equal_(slots_[index].value.first, key)) {
+                    return index;
+                }
+                index = (index + 1) & _mask();
+            }
+            return slots_.size();
+        }
+
+        void _grow(size_type capacity) {
+            std::vector<slot, slot_allocator> old_slots(capacity);
+            old_slots.swap(slots_);
+            for (auto &item: old_slots) {
+                if (item.used) {
+                    size_type index = hash_(item.value.first) & _mask();
+                    while (slots_[index].used) {
+                        index = (index + 1) & _mask();
+                    }
+                    slots_[index].value = std::move(item.value);
+                    slots_[index].used = true;
+                }
+            }
+        }
+
+    public:
+        linear_probing_map() = default;
+
+        template<typename PKey, typename ...Args>
+        std::pair<iterator, bool> emplace(PKey &&key, Args &&...args) {
+            if (static_cast<float>(size_ + 1) > max_load_factor_ * static_cast<float>(slots_.size())) {
+                _grow(std::max(kMinCapacity, slots_.size() * 2));
+            }
+            size_type index = hash_(key) & _mask();
+            while (slots_[index].used) {
+                if (equal_(slots_[index].value.first, key)) {
+                    return std::make_pair(iterator(slots_.data() + index, slots_.data() + slots_.size()), false);
+                }
+                index = (index + 1) & _mask();
+            }
+            slots_[index].value = value_type(std::forward<PKey>(key), TValue(std::forward<Args>(args)...));
+            slots_[index].used = true;
+            size_++;
+            return std::make_pair(iterator(slots_.data() + index, slots_.data() + slots_.size()), true);
+        }
+
+        iterator find(const key_type &key) {
+            return iterator(slots_.data() + _find_index(key), slots_.data() + slots_.size());
+        }
+
+        const_iterator find(const key_type &key) const {
+            return const_iterator(slots_.data() + _find_index(key), slots_.data() + slots_.size());
+        }
+
+        size_type erase(const key_type &key) {
+            size_type index = _find_index(key);
+            if (index == slots_.size()) {
+                return 0;
+            }
+            size_type hole = index;
+            size_type current = (index + 1) & _mask();
+            while (slots_[current].used) {
+                size_type home = hash_(slots_[current].value.first) & _mask();
+                if (((current - home) & _mask()) >= ((current - hole) & _mask())) {
+                    slots_[hole].value = std::move(slots_[current].value);
+                    hole = current;
+                }
+                current = (current + 1) & _mask();
+            }
+            slots_[hole].value = value_type();
+            slots_[hole].used = false;
+            size_--;
+            return 1;
+        }
+
+        void rehash(size_type capacity) {
+            size_type new_capacity = std::max(kMinCapacity, slots_.size());
+            while (new_capacity < capacity ||
+                   static_cast<float>(size_) >= max_load_factor_ * static_cast<float>(new_capacity)) {
+                new_capacity *= 2;
+            }
+            if (new_capacity != slots_.size()) {
+                _grow(new_capacity);
+            }
+        }
+
+        float max_load_factor() const {
+            return max_load_factor_;
+        }
+
+        void max_load_factor(float load_factor) {
+            max_load_factor_ = std::min(load_factor, 0.95f);
+            rehash(slots_.size());
+        }
+
+        size_type bucket_count() const {
+            return slots_.size();
+        }
+
+        size_type size() const {
+            return size_;
+        }
+
+        probe_stats stats() const {
+            probe_stats result;
+            size_type total_displacement = 0;
+            size_type current_cluster = 0;
+            for (size_type index = 0; index < slots_.size(); ++index) {
+                if (!slots_[index].used) {
+                    result.longest_cluster = std::max(result.longest_cluster, current_cluster);
+                    current_cluster = 0;
+                    continue;
+                }
+                size_type displacement = (index - (hash_(slots_[index].value.first) & _mask())) & _mask();
+                total_displacement += displacement;
+                result.max_displacement = std::max(result.max_displacement, displacement);
+                current_cluster++;
+            }
+            result.longest_cluster = std::max(result.longest_cluster, current_cluster);
+            if (size_ != 0) {
+                result.mean_displacement = static_cast<double>(total_displacement) / static_cast<double>(size_);
+            }
+            return result;
+        }
+
+        iterator begin() {
+            iterator result(slots_.data(), slots_.data() + slots_.size());
+            result.skip_unused();
+            return result;
+        }
+
+        iterator end() {
+            return iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+        }
+
+        const_iterator begin() const {
+            const_iterator result(slots_.data(), slots_.data() + slots_.size());
+            result.skip_unused();
+            return result;
+        }
+
+        const_iterator end() const {
+            return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size());
+        }
+
+    private:
+        template<typename TSlot, typename TItem>
+        class linear_probing_iterator {
+            friend class linear_probing_map;
+
+        private:
+            TSlot *data_;
+            TSlot *last_;
+
+            linear_probing_iterator(TSlot *data, TSlot *last)
+                    : data_(data),
+                      last_(last) {}
+
+            void skip_unused() {
+                while (data_ != last_ && !data_->used) {
+                    ++data_;
+                }
+            }
+
+        public:
+            TItem &operator*() const {
+                return data_->value;
+            }
+
+            TItem *operator->() const {
+                return &data_->value;
+            }
+
+            bool operator==(const linear_probing_iterator &other) const {
+                return data_ == other.data_;
+            }
+
+            bool operator!=(const linear_probing_iterator &other) const {
+                return data_ != other.data_;
+            }
+
+            linear_probing_iterator &operator++() {
+                ++data_;
+                skip_unused();
+                return *this;
+            }
+        };
+    };
+}
+
+#endif //HASHMAP_BENCH_BASELINE_H
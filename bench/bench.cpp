@@ -0,0 +1,770 @@
+#include "robin_hood.h"
+#include "baseline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace bench {
+
+    size_t allocated_bytes = 0;
+
+    template<typename T>
+    class counting_allocator {
+    public:
+        using value_type = T;
+
+        counting_allocator() = default;
+
+        template<typename U>
+        counting_allocator(const counting_allocator<U> &) noexcept {}
+
+        T *allocate(size_t count) {
+            allocated_bytes += count * sizeof(T);
+            return std::allocator<T>().allocate(count);
+        }
+
+        void deallocate(T *pointer, size_t count) noexcept {
+            allocated_bytes -= count * sizeof(T);
+            std::allocator<T>().deallocate(pointer, count);
+        }
+
+        template<typename U>
+        bool operator==(const counting_allocator<U> &) const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const counting_allocator<U> &) const noexcept {
+            return false;
+        }
+    };
+
+    struct big_value {
+        uint64_t data[32]{};
+
+        big_value() = default;
+
+        explicit big_value(uint64_t seed) {
+            data[0] = seed;
+        }
+    };
+
+    class random {
+        uint64_t state_;
+
+    public:
+        explicit random(uint64_t seed)
+                : state_(seed) {}
+
+        uint64_t operator()() {
+            uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27u)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31u);
+        }
+    };
+
+    template<typename TKey>
+    TKey make_key(uint64_t bits);
+
+    template<>
+    uint64_t make_key<uint64_t>(uint64_t bits) {
+        return bits;
+    }
+
+    template<>
+    std::string make_key<std::string>(uint64_t bits) {
+        static const char digits[] = "0123456789abcdef";
+        std::string result = "key:";
+        for (int i = 0; i < 16; ++i) {
+            result.push_back(digits[(bits >> (i * 4u)) & 0xfu]);
+        }
+        return result;
+    }
+
+    template<typename TKey>
+    std::vector<TKey> make_keys(size_t count, uint64_t seed) {
+        random generator(seed);
+        std::vector<TKey> keys;
+        keys.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            keys.push_back(make_key<TKey>(generator()));
+        }
+        return keys;
+    }
+
+    enum class distribution {
+        random,
+        sequential,
+        strided,
+        zipfian,
+        collision
+    };
+
+    const char *distribution_name(distribution kind) {
+        switch (kind) {
+            case distribution::sequential:
+                return "seq";
+            case distribution::strided:
+                return "stride";
+            case distribution::zipfian:
+                return "zipf";
+            case distribution::collision:
+                return "collide";
+            default:
+                return "random";
+        }
+    }
+
+    // Distinct keys for one benchmark run: consecutive, evenly spaced, or colliding under an identity hash.
+    // Random and zipfian runs use random keys; zipfian skews only the lookups, see make_zipfian_lookups.
+    std::vector<uint64_t> make_distribution_keys(distribution kind, size_t count, uint64_t seed) {
+        static constexpr const uint64_t kStride = 64;
+
+        std::vector<uint64_t> keys;
+        keys.reserve(count);
+        uint64_t base = seed * (uint64_t(1) << 40u);
+        for (size_t i = 0; i < count; ++i) {
+            switch (kind) {
+                case distribution::sequential:
+                    keys.push_back(base + i);
+                    break;
+                case distribution::strided:
+                    keys.push_back(base + i * kStride);
+                    break;
+                case distribution::collision:
+                    // Distinct but sharing their low 32 bits, so an identity hash lands them in one bucket.
+                    keys.push_back((seed * count + i) << 32u);
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (keys.empty()) {
+            keys = make_keys<uint64_t>(count, seed);
+        }
+        return keys;
+    }
+
+    template<typename TKey>
+    std::vector<TKey> make_zipfian_lookups(const std::vector<TKey> &keys, size_t count, double skew) {
+        std::vector<double> cumulative(keys.size());
+        double total = 0;
+        for (size_t rank = 0; rank < keys.size(); ++rank) {
+            total += 1.0 / std::pow(static_cast<double>(rank + 1), skew);
+            cumulative[rank] = total;
+        }
+
+        random generator(keys.size());
+        std::vector<TKey> lookups;
+        lookups.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            double point = static_cast<double>(generator() >> 11u) * 0x1.0p-53 * total;
+            size_t rank = std::lower_bound(cumulative.begin(), cumulative.end(), point) - cumulative.begin();
+            lookups.push_back(keys[std::min(rank, keys.size() - 1)]);
+        }
+        return lookups;
+    }
+
+    template<typename TFirst, typename TSecond>
+    const TFirst &key_of(const std::pair<TFirst, TSecond> &value) {
+        return value.first;
+    }
+
+    template<typename TKey>
+    const TKey &key_of(const TKey &value) {
+        return value;
+    }
+
+    inline size_t touch(uint64_t value) {
+        return static_cast<size_t>(value);
+    }
+
+    inline size_t touch(const std::string &value) {
+        return value.size();
+    }
+
+    template<typename Container, typename TKey>
+    void put(Container &container, const TKey &key) {
+        if constexpr (std::is_same<typename Container::value_type, TKey>::value) {
+            container.insert(key);
+        } else {
+            container.emplace(key, typename Container::mapped_type());
+        }
+    }
+
+    struct options {
+        std::vector<size_t> sizes{1u << 10u, 1u << 13u, 1u << 16u, 1u << 19u, 1u << 22u};
+        size_t min_operations{1u << 20u};
+        size_t max_bytes{size_t(256) << 20u};
+        size_t max_collision_size{1u << 12u};
+        double zipf_skew{0.99};
+        std::vector<float> load_factors{0.5f, 0.7f, 0.9f};
+        std::string filter;
+        bool csv{false};
+    };
+
+    struct result {
+        std::string container;
+        std::string key;
+        std::string operation;
+        size_t size;
+        double ns_per_operation;
+        double bytes_per_element;
+        double mean_probe;
+        size_t max_probe;
+    };
+
+    class reporter {
+        const options &options_;
+
+    public:
+        explicit reporter(const options &options)
+                : options_(options) {
+            if (options_.csv) {
+                std::printf("container,key,operation,size,ns_per_op,bytes_per_element,mean_probe,max_probe\n");
+            } else {
+                std::printf("%-28s %-14s %-12s %10s %12s %12s %10s %10s\n",
+                            "container", "key", "operation", "size", "ns/op", "bytes/elem", "mean probe", "max probe");
+            }
+        }
+
+        void report(const result &item) const {
+            if (options_.csv) {
+                std::printf("%s,%s,%s,%zu,%.2f,%.2f,%.2f,%zu\n", item.container.c_str(), item.key.c_str(),
+                            item.operation.c_str(), item.size, item.ns_per_operation, item.bytes_per_element,
+                            item.mean_probe, item.max_probe);
+            } else {
+                std::printf("%-28s %-14s %-12s %10zu %12.2f %12.2f %10.2f %10zu\n", item.container.c_str(),
+                            item.key.c_str(), item.operation.c_str(), item.size, item.ns_per_operation,
+                            item.bytes_per_element, item.mean_probe, item.max_probe);
+            }
+            std::fflush(stdout);
+        }
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    inline double elapsed_ns(clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    size_t sink = 0;
+
+    template<typename Container, typename = void>
+    struct has_stats : std::false_type {
+    };
+
+    template<typename Container>
+    struct has_stats<Container, std::void_t<decltype(std::declval<const Container &>().stats())>>
+            : std::true_type {
+    };
+
+    template<typename Container, typename = void>
+    struct has_buckets : std::false_type {
+    };
+
+    template<typename Container>
+    struct has_buckets<Container, std::void_t<decltype(std::declval<const Container &>().bucket_size(0))>>
+            : std::true_type {
+    };
+
+    template<typename Container, typename = void>
+    struct has_bulk_load : std::false_type {
+    };
+
+    template<typename Container>
+    struct has_bulk_load<Container, std::void_t<decltype(std::declval<Container &>().bulk_load_unique(
+            std::declval<const typename Container::value_type *>(),
+            std::declval<const typename Container::value_type *>()))>> : std::true_type {
+    };
+
+    template<typename Container, typename = void>
+    struct has_erase_batch : std::false_type {
+    };
+
+    template<typename Container>
+    struct has_erase_batch<Container, std::void_t<decltype(std::declval<Container &>().erase_batch(
+            std::declval<const typename Container::key_type *>(),
+            std::declval<const typename Container::key_type *>()))>> : std::true_type {
+    };
+
+    template<typename Container, typename TKey>
+    typename Container::value_type make_value(const TKey &key) {
+        if constexpr (std::is_same<typename Container::value_type, TKey>::value) {
+            return key;
+        } else {
+            return typename Container::value_type(key, typename Container::mapped_type());
+        }
+    }
+
+    // Open addressing tables report displacement from the home slot, chained tables the chain length walked.
+    template<typename Container>
+    std::pair<double, size_t> probe_lengths(const Container &container) {
+        if constexpr (has_stats<Container>::value) {
+            auto stats = container.stats();
+            return std::make_pair(stats.mean_displacement, static_cast<size_t>(stats.max_displacement));
+        } else if constexpr (has_buckets<Container>::value) {
+            size_t total = 0;
+            size_t longest = 0;
+            for (size_t bucket = 0; bucket < container.bucket_count(); ++bucket) {
+                size_t length = container.bucket_size(bucket);
+                total += length * (length + 1) / 2;
+                longest = std::max(longest, length);
+            }
+            double mean = container.size() == 0 ? 0 : static_cast<double>(total) / static_cast<double>(container.size());
+            return std::make_pair(mean, longest);
+        } else {
+            return std::make_pair(0.0, size_t(0));
+        }
+    }
+
+    template<typename Container, typename TKey>
+    class suite {
+        const std::string container_;
+        const std::string key_;
+        const std::vector<TKey> &keys_;
+        const std::vector<TKey> &misses_;
+        const std::vector<TKey> &hits_;
+        const float max_load_factor_;
+        const options &options_;
+        const reporter &reporter_;
+        double bytes_per_element_{0};
+        double mean_probe_{0};
+        size_t max_probe_{0};
+
+    private:
+        size_t _repeats() const {
+            return std::max<size_t>(1, options_.min_operations / keys_.size());
+        }
+
+        size_t _operations() const {
+            return std::max(options_.min_operations, keys_.size());
+        }
+
+        void _report(const char *operation, double ns_per_operation) const {
+            reporter_.report(result{container_, key_, operation, keys_.size(), ns_per_operation, bytes_per_element_,
+                                    mean_probe_, max_probe_});
+        }
+
+        Container _make() const {
+            Container container;
+            if (max_load_factor_ > 0) {
+                container.max_load_factor(max_load_factor_);
+            }
+            return container;
+        }
+
+        Container _build() const {
+            Container container = _make();
+            for (const auto &key: keys_) {
+                put(container, key);
+            }
+            return container;
+        }
+
+    public:
+        suite(std::string container, std::string key, const std::vector<TKey> &keys, const std::vector<TKey> &misses,
+              const std::vector<TKey> &hits, float max_load_factor, const options &options, const reporter &reporter)
+                : container_(std::move(container)),
+                  key_(std::move(key)),
+                  keys_(keys),
+                  misses_(misses),
+                  hits_(hits),
+                  max_load_factor_(max_load_factor),
+                  options_(options),
+                  reporter_(reporter) {}
+
+        void probe() {
+            Container container = _build();
+            std::tie(mean_probe_, max_probe_) = probe_lengths(container);
+        }
+
+        void insert() {
+            size_t repeats = _repeats();
+            double total = 0;
+            for (size_t i = 0; i < repeats; ++i) {
+                size_t before = allocated_bytes;
+                auto start = clock::now();
+                {
+                    Container container = _make();
+                    for (const auto &key: keys_) {
+                        put(container, key);
+                    }
+                    total += elapsed_ns(start);
+                    bytes_per_element_ = static_cast<double>(allocated_bytes - before) /
+                                         static_cast<double>(keys_.size());
+                    sink += container.size();
+                }
+            }
+            _report("insert", total / static_cast<double>(repeats * keys_.size()));
+        }
+
+        // Loading keys that are known to be unique, for the containers that can skip the duplicate checks.
+        void bulk_load() {
+            if constexpr (has_bulk_load<Container>::value) {
+                std::vector<typename Container::value_type> values;
+                values.reserve(keys_.size());
+                for (const auto &key: keys_) {
+                    values.push_back(make_value<Container>(key));
+                }
+                size_t repeats = _repeats();
+                double total = 0;
+                for (size_t i = 0; i < repeats; ++i) {
+                    auto start = clock::now();
+                    {
+                        Container container = _make();
+                        container.bulk_load_unique(values.data(), values.data() + values.size());
+                        total += elapsed_ns(start);
+                        sink += container.size();
+                    }
+                }
+                _report("bulk_load", total / static_cast<double>(repeats * keys_.size()));
+            }
+        }
+
+        void find_hit() {
+            Container container = _build();
+            size_t operations = _operations();
+            size_t found = 0;
+            auto start = clock::now();
+            for (size_t i = 0; i < operations; ++i) {
+                found += container.find(hits_[i % hits_.size()]) != container.end();
+            }
+            _report("find_hit", elapsed_ns(start) / static_cast<double>(operations));
+            sink += found;
+        }
+
+        void find_miss() {
+            Container container = _build();
+            size_t operations = _operations();
+            size_t found = 0;
+            auto start = clock::now();
+            for (size_t i = 0; i < operations; ++i) {
+                found += container.find(misses_[i % misses_.size()]) != container.end();
+            }
+            _report("find_miss", elapsed_ns(start) / static_cast<double>(operations));
+            sink += found;
+        }
+
+        void erase() {
+            size_t repeats = _repeats();
+            double total = 0;
+            for (size_t i = 0; i < repeats; ++i) {
+                Container container = _build();
+                auto start = clock::now();
+                for (const auto &key: keys_) {
+                    container.erase(key);
+                }
+                total += elapsed_ns(start);
+                sink += container.size();
+            }
+            _report("erase", total / static_cast<double>(repeats * keys_.size()));
+        }
+
+        void erase_batch() {
+            if constexpr (has_erase_batch<Container>::value) {
+                size_t repeats = _repeats();
+                double total = 0;
+                for (size_t i = 0; i < repeats; ++i) {
+                    Container container = _build();
+                    auto start = clock::now();
+                    sink += container.erase_batch(keys_.data(), keys_.data() + keys_.size());
+                    total += elapsed_ns(start);
+                }
+                _report("erase_batch", total / static_cast<double>(repeats * keys_.size()));
+            }
+        }
+
+        void iterate() {
+            Container container = _build();
+            size_t repeats = _repeats();
+            size_t sum = 0;
+            auto start = clock::now();
+            for (size_t i = 0; i < repeats; ++i) {
+                for (const auto &value: container) {
+                    sum += touch(key_of(value));
+                }
+            }
+            _report("iterate", elapsed_ns(start) / static_cast<double>(repeats * keys_.size()));
+            sink += sum;
+        }
+
+        void rehash() {
+            size_t repeats = std::max<size_t>(1, _repeats() / 4);
+            double total = 0;
+            for (size_t i = 0; i < repeats; ++i) {
+                Container container = _build();
+                auto start = clock::now();
+                container.rehash(container.bucket_count() * 2 - 1);
+                total += elapsed_ns(start);
+                sink += container.size();
+            }
+            _report("rehash", total / static_cast<double>(repeats * keys_.size()));
+        }
+
+        void mixed() {
+            Container container = _build();
+            std::vector<TKey> present = keys_;
+            size_t operations = _operations();
+            size_t next_fresh = 0;
+            random generator(operations);
+            size_t found = 0;
+            auto start = clock::now();
+            for (size_t i = 0; i < operations; ++i) {
+                uint64_t choice = generator();
+                switch (choice & 3u) {
+                    case 0:
+                    case 1:
+                        if (!present.empty()) {
+                            found += container.find(present[(choice >> 2u) % present.size()]) != container.end();
+                        }
+                        break;
+                    case 2:
+                        put(container, misses_[next_fresh]);
+                        present.push_back(misses_[next_fresh]);
+                        next_fresh = (next_fresh + 1) % misses_.size();
+                        break;
+                    default:
+                        if (!present.empty()) {
+                            size_t index = (choice >> 2u) % present.size();
+                            container.erase(present[index]);
+                            std::swap(present[index], present.back());
+                            present.pop_back();
+                        }
+                        break;
+                }
+            }
+            _report("mixed", elapsed_ns(start) / static_cast<double>(operations));
+            sink += found;
+        }
+
+        void run_all() {
+            probe();
+            insert();
+            bulk_load();
+            find_hit();
+            find_miss();
+            erase();
+            erase_batch();
+            iterate();
+            rehash();
+            mixed();
+        }
+    };
+
+    template<typename TKey>
+    struct workload {
+        std::string name;
+        std::vector<TKey> keys;
+        std::vector<TKey> misses;
+        std::vector<TKey> hits;
+        float max_load_factor{0};
+    };
+
+    template<typename TKey>
+    workload<TKey> make_workload(const std::string &name, size_t size) {
+        workload<TKey> result{name, make_keys<TKey>(size, 1), make_keys<TKey>(size, 2), {}, 0};
+        result.hits = result.keys;
+        return result;
+    }
+
+    workload<uint64_t> make_workload(distribution kind, size_t size, const options &options) {
+        workload<uint64_t> result;
+        result.name = std::string("u64/") + distribution_name(kind);
+        result.keys = make_distribution_keys(kind, size, 1);
+        result.misses = make_distribution_keys(kind, size, 2);
+        if (kind == distribution::zipfian) {
+            result.hits = make_zipfian_lookups(result.keys, std::max(options.min_operations, size), options.zipf_skew);
+        } else {
+            result.hits = result.keys;
+        }
+        return result;
+    }
+
+    template<typename Container, typename TKey>
+    void run(const std::string &container, const workload<TKey> &load, const options &options,
+             const reporter &reporter) {
+        std::string name = container + "/" + load.name;
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+            return;
+        }
+        suite<Container, TKey>(container, load.name, load.keys, load.misses, load.hits, load.max_load_factor, options,
+                               reporter).run_all();
+    }
+
+    template<typename TKey, typename TValue>
+    using ld_map = ld::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    // Same indexing as the default policy, but without kModuloIndex the table rehashes by re-inserting every node,
+    // which is what the streaming rehash is measured against.
+    struct reinsert_growth_policy : ld::power_of_two_growth_policy {
+        static constexpr const bool kModuloIndex = false;
+    };
+
+    template<typename TKey, typename TValue>
+    using ld_reinsert_map = ld::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>, reinsert_growth_policy>;
+
+    template<typename TKey, typename TValue>
+    using ld_stable_map = ld::stable_unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey, typename TValue>
+    using ld_split_map = ld::split_unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey, typename TValue>
+    using ld_prime_map = ld::unordered_prime_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey, typename TValue>
+    using ld_fastrange_map = ld::unordered_fastrange_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey, typename TValue>
+    using std_map = std::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey, typename TValue>
+    using linear_map = linear_probing_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>,
+            counting_allocator<std::pair<const TKey, TValue>>>;
+
+    template<typename TKey>
+    using ld_set = ld::unordered_set<TKey, std::hash<TKey>, std::equal_to<TKey>, counting_allocator<TKey>>;
+
+    template<typename TKey>
+    using ld_prime_set = ld::unordered_prime_set<TKey, std::hash<TKey>, std::equal_to<TKey>, counting_allocator<TKey>>;
+
+    template<typename TKey>
+    using std_set = std::unordered_set<TKey, std::hash<TKey>, std::equal_to<TKey>, counting_allocator<TKey>>;
+
+    template<typename TKey, typename TValue>
+    void run_maps(const workload<TKey> &load, const options &options, const reporter &reporter) {
+        if (load.keys.size() * (sizeof(TKey) + sizeof(TValue)) > options.max_bytes) {
+            return;
+        }
+        run<ld_map<TKey, TValue>>("ld::unordered_map", load, options, reporter);
+        run<ld_reinsert_map<TKey, TValue>>("ld::unordered_map(reinsert)", load, options, reporter);
+        run<ld_stable_map<TKey, TValue>>("ld::stable_unordered_map", load, options, reporter);
+        run<ld_split_map<TKey, TValue>>("ld::split_unordered_map", load, options, reporter);
+        run<ld_prime_map<TKey, TValue>>("ld::unordered_prime_map", load, options, reporter);
+        run<ld_fastrange_map<TKey, TValue>>("ld::unordered_fastrange_map", load, options, reporter);
+        run<std_map<TKey, TValue>>("std::unordered_map", load, options, reporter);
+        run<linear_map<TKey, TValue>>("linear_probing_map", load, options, reporter);
+    }
+
+    template<typename TKey>
+    void run_sets(const workload<TKey> &load, const options &options, const reporter &reporter) {
+        if (load.keys.size() * sizeof(TKey) > options.max_bytes) {
+            return;
+        }
+        run<ld_set<TKey>>("ld::unordered_set", load, options, reporter);
+        run<ld_prime_set<TKey>>("ld::unordered_prime_set", load, options, reporter);
+        run<std_set<TKey>>("std::unordered_set", load, options, reporter);
+    }
+
+    std::vector<size_t> parse_sizes(const char *text) {
+        std::vector<size_t> sizes;
+        while (*text != '\0') {
+            char *end = nullptr;
+            sizes.push_back(std::strtoull(text, &end, 10));
+            text = *end == ',' ? end + 1 : end;
+            if (end == text && *end != '\0') {
+                break;
+            }
+        }
+        return sizes;
+    }
+
+    bool parse_options(int argc, char **argv, options &result) {
+        for (int i = 1; i < argc; ++i) {
+            const char *argument = argv[i];
+            if (std::strncmp(argument, "--sizes=", 8) == 0) {
+                result.sizes = parse_sizes(argument + 8);
+            } else if (std::strncmp(argument, "--ops=", 6) == 0) {
+                result.min_operations = std::strtoull(argument + 6, nullptr, 10);
+            } else if (std::strncmp(argument, "--max-mb=", 9) == 0) {
+                result.max_bytes = std::strtoull(argument + 9, nullptr, 10) << 20u;
+            } else if (std::strncmp(argument, "--max-collide=", 14) == 0) {
+                result.max_collision_size = std::strtoull(argument + 14, nullptr, 10);
+            } else if (std::strncmp(argument, "--zipf=", 7) == 0) {
+                result.zipf_skew = std::strtod(argument + 7, nullptr);
+            } else if (std::strncmp(argument, "--load-factors=", 15) == 0) {
+                result.load_factors.clear();
+                for (const char *text = argument + 15; *text != '\0';) {
+                    char *end = nullptr;
+                    result.load_factors.push_back(std::strtof(text, &end));
+                    if (end == text) {
+                        break;
+                    }
+                    text = *end == ',' ? end + 1 : end;
+                }
+            } else if (std::strncmp(argument, "--filter=", 9) == 0) {
+                result.filter = argument + 9;
+            } else if (std::strcmp(argument, "--csv") == 0) {
+                result.csv = true;
+            } else {
+                std::fprintf(stderr,
+                             "usage: %s [--sizes=N,N,...] [--ops=N] [--max-mb=N] [--max-collide=N] [--zipf=S] "
+                             "[--load-factors=F,F,...] "
+                             "[--filter=TEXT] [--csv]\n",
+                             argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv) {
+    bench::options options;
+    if (!bench::parse_options(argc, argv, options)) {
+        return 1;
+    }
+    bench::reporter reporter(options);
+
+    for (size_t size: options.sizes) {
+        auto integers = bench::make_workload<uint64_t>("u64", size);
+        bench::run_maps<uint64_t, uint64_t>(integers, options, reporter);
+        bench::run_maps<std::string, uint64_t>(bench::make_workload<std::string>("string", size), options, reporter);
+        integers.name = "u64/256B";
+        bench::run_maps<uint64_t, bench::big_value>(integers, options, reporter);
+        integers.name = "u64";
+        bench::run_sets<uint64_t>(integers, options, reporter);
+    }
+
+    for (size_t size: options.sizes) {
+        for (auto kind: {bench::distribution::sequential, bench::distribution::strided,
+                         bench::distribution::zipfian, bench::distribution::collision}) {
+            if (kind == bench::distribution::collision && size > options.max_collision_size) {
+                continue;
+            }
+            auto load = bench::make_workload(kind, size, options);
+            bench::run_maps<uint64_t, uint64_t>(load, options, reporter);
+            bench::run_sets<uint64_t>(load, options, reporter);
+        }
+    }
+
+    for (size_t size: options.sizes) {
+        auto load = bench::make_workload<uint64_t>("u64", size);
+        for (float load_factor: options.load_factors) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "u64@%.2f", load_factor);
+            load.name = name;
+            load.max_load_factor = load_factor;
+            bench::run_maps<uint64_t, uint64_t>(load, options, reporter);
+        }
+    }
+    return bench::sink == 42 ? 2 : 0;
+}
@@ -3,10 +3,42 @@
 
 #include <utility>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <climits>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <execution>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <tuple>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LD_ROBIN_HOOD_SSE2
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#ifndef LD_ROBIN_HOOD_DEFAULT_LOAD_FACTOR
+#define LD_ROBIN_HOOD_DEFAULT_LOAD_FACTOR 0.5f
+#endif
 
 namespace ld {
 
+    class no_instrumentation;
+
     namespace detail {
 
         template<typename TValue>
@@ -261,7 +293,7 @@ namespace ld {
                 pointer new_data = allocator_traits::allocate(allocator_, new_size);
                 for (size_type i = 0; i < new_size; ++i) {
                     try {
-                        allocator_traits::construct(allocator_, new_data + i, data_[i]);
+                        allocator_traits::construct(allocator_, new_data + i, other.data_[i]);
                     } catch (...) {
                         for (size_type j = 0; j < i; ++j) {
                             allocator_traits::destroy(allocator_, new_data + j);
@@ -379,6 +411,14 @@ namespace ld {
                 size_ = 0;
             }
 
+            void reallocate(size_type new_size) {
+                data_ = allocator_.reallocate(data_, size_, new_size);
+                for (size_type i = size_; i < new_size; ++i) {
+                    allocator_traits::construct(allocator_, data_ + i);
+                }
+                size_ = new_size;
+            }
+
             void resize(size_type new_size) {
                 resize(new_size, {});
             }
@@ -628,16 +668,304 @@ namespace ld {
             };
         };
 
+        inline size_t count_trailing_zeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanForward64(&index, word);
+            return index;
+#else
+            size_t index = 0;
+            while ((word & 1u) == 0) {
+                word >>= 1u;
+                ++index;
+            }
+            return index;
+#endif
+        }
+
+        inline size_t count_leading_zeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_clzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long index;
+            _BitScanReverse64(&index, word);
+            return 63 - index;
+#else
+            size_t index = 0;
+            while ((word & (uint64_t(1) << 63u)) == 0) {
+                word <<= 1u;
+                ++index;
+            }
+            return index;
+#endif
+        }
+
+        inline void prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#else
+            (void) address;
+#endif
+        }
+
+        // Compares Size bytes, 16 at a time with SSE2 when Size is a multiple of 16.
+        template<size_t Size>
+        inline bool equal_bytes(const void *first, const void *second) {
+#if defined(LD_ROBIN_HOOD_SSE2)
+            if constexpr (Size % 16 == 0) {
+                const auto *lhs = static_cast<const __m128i *>(first);
+                const auto *rhs = static_cast<const __m128i *>(second);
+                __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(lhs), _mm_loadu_si128(rhs));
+                for (size_t chunk = 1; chunk < Size / 16; ++chunk) {
+                    equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128(lhs + chunk),
+                                                                _mm_loadu_si128(rhs + chunk)));
+                }
+                return _mm_movemask_epi8(equal) == 0xffff;
+            }
+#endif
+            return std::memcmp(first, second, Size) == 0;
+        }
+
+        inline uint64_t multiply_mix(uint64_t first, uint64_t second) {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t product = static_cast<__uint128_t>(first) * second;
+            return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64u);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            uint64_t high;
+            uint64_t low = _umul128(first, second, &high);
+            return low ^ high;
+#else
+            uint64_t product = first * second;
+            return product ^ (product >> 32u);
+#endif
+        }
+
+        inline uint64_t multiply_high(uint64_t first, uint64_t second) {
+#if defined(__SIZEOF_INT128__)
+            return static_cast<uint64_t>((static_cast<__uint128_t>(first) * second) >> 64u);
+#elif defined(_MSC_VER) && defined(_M_X64)
+            return __umulh(first, second);
+#else
+            uint64_t first_low = first & 0xffffffffu;
+            uint64_t first_high = first >> 32u;
+            uint64_t second_low = second & 0xffffffffu;
+            uint64_t second_high = second >> 32u;
+            uint64_t cross = (first_low * second_low >> 32u) + (first_high * second_low & 0xffffffffu) +
+                             first_low * second_high;
+            return first_high * second_high + (first_high * second_low >> 32u) + (cross >> 32u);
+#endif
+        }
+
+        inline uint64_t read_word(const unsigned char *data, size_t length) {
+            uint64_t word = 0;
+            std::memcpy(&word, data, length);
+            return word;
+        }
+
+        inline uint64_t hash_bytes(const void *data, size_t length, uint64_t seed) {
+            static constexpr const uint64_t kFirstSecret = 0xa0761d6478bd642full;
+            static constexpr const uint64_t kSecondSecret = 0xe7037ed1a0b428dbull;
+
+            const auto *bytes = static_cast<const unsigned char *>(data);
+            uint64_t hash = seed ^ kFirstSecret;
+            while (length >= sizeof(uint64_t)) {
+                hash = multiply_mix(read_word(bytes, sizeof(uint64_t)) ^ kSecondSecret, hash ^ kFirstSecret);
+                bytes += sizeof(uint64_t);
+                length -= sizeof(uint64_t);
+            }
+            hash = multiply_mix(read_word(bytes, length) ^ kSecondSecret, hash ^ length);
+            return multiply_mix(hash ^ kFirstSecret, seed ^ kSecondSecret);
+        }
+
+        inline uint64_t random_seed() {
+            std::random_device device;
+            return (static_cast<uint64_t>(device()) << 32u) ^ device();
+        }
+
+        inline uint64_t process_seed() {
+            static const uint64_t seed = random_seed();
+            return seed;
+        }
+
+        template<typename Hasher, typename = void>
+        struct is_reseedable : std::false_type {
+        };
+
+        template<typename Hasher>
+        struct is_reseedable<Hasher, std::void_t<decltype(std::declval<Hasher &>().reseed(uint64_t()))>>
+                : std::true_type {
+        };
+
+        template<typename Allocator, typename = void>
+        struct has_reallocate : std::false_type {
+        };
+
+        template<typename Allocator>
+        struct has_reallocate<Allocator, std::void_t<decltype(std::declval<Allocator &>().reallocate(
+                std::declval<typename std::allocator_traits<Allocator>::pointer>(), size_t(), size_t()))>>
+                : std::true_type {
+        };
+
+        template<typename T, typename = void>
+        struct is_transparent : std::false_type {
+        };
+
+        template<typename T>
+        struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type {
+        };
+
+        template<typename T>
+        struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+        };
+
+        template<typename TFirst, typename TSecond>
+        struct is_trivially_relocatable<std::pair<TFirst, TSecond>>
+                : std::bool_constant<is_trivially_relocatable<TFirst>::value &&
+                                     is_trivially_relocatable<TSecond>::value> {
+        };
+
+        template<typename GrowthPolicy, typename = void>
+        struct has_modulo_index : std::false_type {
+        };
+
+        template<typename GrowthPolicy>
+        struct has_modulo_index<GrowthPolicy, std::enable_if_t<GrowthPolicy::kModuloIndex>> : std::true_type {
+        };
+
+        template<typename GrowthPolicy, typename = void>
+        struct has_capacity_for : std::false_type {
+        };
+
+        template<typename GrowthPolicy>
+        struct has_capacity_for<GrowthPolicy, std::void_t<decltype(std::declval<const GrowthPolicy &>().capacity_for(
+                size_t()))>> : std::true_type {
+        };
+
+        template<typename GrowthPolicy>
+        size_t capacity_for(const GrowthPolicy &growth_policy, size_t needed_capacity, size_t current_capacity) {
+            current_capacity = std::max(current_capacity, size_t(1));
+            if constexpr (has_capacity_for<GrowthPolicy>::value) {
+                return std::max(current_capacity, growth_policy.capacity_for(needed_capacity));
+            } else {
+                while (needed_capacity >= current_capacity) {
+                    current_capacity = growth_policy(current_capacity);
+                }
+                return current_capacity;
+            }
+        }
+
+        template<typename Allocator = std::allocator<uint64_t>>
+        class bitmap {
+        public:
+            using word_type = uint64_t;
+            using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<word_type>;
+            using words = array<word_type, allocator_type>;
+            using size_type = typename words::size_type;
+            using difference_type = typename words::difference_type;
+
+            static constexpr const size_type kWordBits = 64;
+
+        private:
+            words words_;
+
+        public:
+            bitmap() = default;
+
+            explicit bitmap(size_type size, const allocator_type &allocator = allocator_type{})
+                    : words_((size + kWordBits - 1) / kWordBits, allocator) {}
+
+            void set(size_type index) {
+                words_[index / kWordBits] |= word_type(1) << (index % kWordBits);
+            }
+
+            void reset(size_type index) {
+                words_[index / kWordBits] &= ~(word_type(1) << (index % kWordBits));
+            }
+
+            bool test(size_type index) const {
+                return (words_[index / kWordBits] >> (index % kWordBits)) & 1u;
+            }
+
+            void clear() {
+                words_.clear();
+            }
+
+            const word_type *data() const noexcept {
+                return words_.data();
+            }
+
+            size_type allocated_bytes() const noexcept {
+                return words_.size() * sizeof(word_type);
+            }
+
+            static size_type find_next(const word_type *words, size_type index, size_type size) {
+                if (index >= size) {
+                    return size;
+                }
+                size_type word_index = index / kWordBits;
+                word_type word = words[word_index] & (~word_type(0) << (index % kWordBits));
+                while (word == 0) {
+                    if (++word_index * kWordBits >= size) {
+                        return size;
+                    }
+                    word = words[word_index];
+                }
+                return std::min(size, word_index * kWordBits + count_trailing_zeros(word));
+            }
+
+            static difference_type find_prior(const word_type *words, size_type index) {
+                if (index == 0) {
+                    return -1;
+                }
+                --index;
+                size_type word_index = index / kWordBits;
+                word_type word = words[word_index] & (~word_type(0) >> (kWordBits - 1 - index % kWordBits));
+                while (word == 0) {
+                    if (word_index == 0) {
+                        return -1;
+                    }
+                    word = words[--word_index];
+                }
+                return word_index * kWordBits + kWordBits - 1 - count_leading_zeros(word);
+            }
+
+            size_type find_next(size_type index, size_type size) const {
+                return find_next(words_.data(), index, size);
+            }
+
+            difference_type find_prior(size_type index) const {
+                return find_prior(words_.data(), index);
+            }
+
+            template<typename Function>
+            void for_each_set(Function function) const {
+                for (size_type word_index = 0; word_index < words_.size(); ++word_index) {
+                    word_type word = words_[word_index];
+                    while (word != 0) {
+                        function(word_index * kWordBits + count_trailing_zeros(word));
+                        word &= word - 1;
+                    }
+                }
+            }
+        };
+
         template<typename TValue>
         class robin_hood_node {
         public:
             using hash_type = size_t;
             using value_type = TValue;
-            using storage = storage<TValue>;
+            using storage = detail::storage<TValue>;
+
+            static constexpr const bool kRelocatable = is_trivially_relocatable<TValue>::value;
 
         private:
             static const uint8_t kNoEmptyMarker = 1;
             static const uint8_t kEmptyMarker = 0;
+            static const uint8_t kSentinelMarker = 2;
             static const hash_type kDefaultHash = 0;
 
             uint8_t empty_;
@@ -659,7 +987,7 @@ namespace ld {
             robin_hood_node(const robin_hood_node &other) noexcept(std::is_nothrow_copy_constructible_v<value_type>)
                     : empty_(other.empty_),
                       hash_(other.hash_) {
-                if (!other.empty()) {
+                if (other._has_value()) {
                     value_.construct(*other.value_);
                 }
             }
@@ -667,7 +995,7 @@ namespace ld {
             robin_hood_node(robin_hood_node &&other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
                     : empty_(other.empty_),
                       hash_(other.hash_) {
-                if (!other.empty()) {
+                if (other._has_value()) {
                     value_.construct(std::move(*other.value_));
                 }
                 other.clear();
@@ -679,7 +1007,7 @@ namespace ld {
 
             robin_hood_node &operator=(const robin_hood_node &other) {
                 clear();
-                if (!other.empty()) {
+                if (other._has_value()) {
                     value_.construct(*other.value_);
                 }
                 hash_ = other.hash_;
@@ -690,7 +1018,7 @@ namespace ld {
             robin_hood_node &
             operator=(robin_hood_node &&other) noexcept(std::is_nothrow_move_constructible<value_type>::value) {
                 clear();
-                if (!other.empty()) {
+                if (other._has_value()) {
                     value_.construct(std::move(*other.value_));
                 }
                 hash_ = other.hash_;
@@ -701,7 +1029,7 @@ namespace ld {
 
             template<typename ...Args>
             void set_data(hash_type hash, Args &&...args) {
-                if (!empty()) {
+                if (_has_value()) {
                     clear();
                 }
                 value_.construct(std::forward<Args>(args)...);
@@ -710,27 +1038,13 @@ namespace ld {
             }
 
             void clear() {
-                if (!empty()) {
+                if (_has_value()) {
                     value_.destruct();
                 }
                 empty_ = kEmptyMarker;
                 hash_ = kDefaultHash;
             }
 
-            void swap(robin_hood_node &other) {
-                if (!other.empty() && !empty()) {
-                    value_type temp_value = std::move(other.value());
-                    other.value_.construct(std::move(value()));
-                    value_.construct(std::move(temp_value));
-                } else if (!other.empty()) {
-                    value_.construct(std::move(other.value()));
-                } else if (!empty()) {
-                    other.value_.construct(std::move(value()));
-                }
-                std::swap(empty_, other.empty_);
-                std::swap(hash_, other.hash_);
-            }
-
             const value_type &value() const {
                 return *value_;
             }
@@ -739,953 +1053,4356 @@ namespace ld {
                 return *value_;
             }
 
+            void make_sentinel() {
+                clear();
+                empty_ = kSentinelMarker;
+            }
+
             bool empty() const {
                 return empty_ == kEmptyMarker;
             }
 
+            bool sentinel() const {
+                return empty_ == kSentinelMarker;
+            }
+
             hash_type hash() const {
                 return hash_;
             }
+
+            void set_hash(hash_type hash) {
+                hash_ = hash;
+            }
+
+        private:
+            bool _has_value() const {
+                return empty_ == kNoEmptyMarker;
+            }
         };
 
-        template<typename Traits>
-        class hash_table {
-            template<typename TItem>
-            class hash_table_iterator;
+        // Slot of a table that keeps its values in a value_pool. It only points at the value, so moving the slot
+        // leaves the value where it is. The table creates and destroys the values through its pool.
+        template<typename TValue>
+        class stable_node {
+        public:
+            using hash_type = size_t;
+            using value_type = TValue;
 
-            using traits_type = Traits;
-            using key_compare = typename Traits::key_compare;
-            using node = robin_hood_node<typename Traits::mutable_value_type>;
-            using node_allocator = typename std::allocator_traits<typename Traits::allocator_type>::template rebind_alloc<node>;
-            using array = array<node, node_allocator>;
-            using node_pointer = typename array::pointer;
+            static constexpr const bool kRelocatable = true;
 
-            static constexpr const float kDefaultLoadFactor = 0.5f;
+        private:
+            static constexpr const hash_type kDefaultHash = 0;
 
-        public:
-            using value_type = typename Traits::value_type;
-            using mutable_value_type = typename Traits::mutable_value_type;
-            using difference_type = std::ptrdiff_t;
-            using reference = typename Traits::value_type &;
-            using const_reference = const typename Traits::value_type &;
-            using pointer = typename Traits::value_type *;
-            using const_pointer = const typename Traits::value_type *;
+            hash_type hash_;
+            value_type *value_;
 
-            using key_type = typename key_compare::key_type;
-            using key_equal = typename key_compare::key_equal;
-            using hasher = typename key_compare::hasher;
+            static value_type *_sentinel_marker() {
+                static uint8_t marker;
+                return reinterpret_cast<value_type *>(&marker);
+            }
 
-            using iterator = hash_table_iterator<value_type>;
-            using const_iterator = hash_table_iterator<const value_type>;
+        public:
+            stable_node()
+                    : hash_(kDefaultHash),
+                      value_(nullptr) {}
 
-            using allocator_type = typename Traits::allocator_type;
+            stable_node(hash_type hash, value_type *value)
+                    : hash_(hash),
+                      value_(value) {}
 
-            using size_type = typename array::size_type;
+            stable_node(const stable_node &other) = default;
 
-        private:
-            traits_type traits_;
+            stable_node(stable_node &&other) noexcept
+                    : hash_(other.hash_),
+                      value_(other.value_) {
+                other.clear();
+            }
 
-            float load_factor_{kDefaultLoadFactor};
-            size_type size_{0};
-            array data_;
+            stable_node &operator=(const stable_node &other) = default;
 
-        private:
-            size_type _next_index(size_type index) const {
-                return (index + 1) % data_.size();
+            stable_node &operator=(stable_node &&other) noexcept {
+                hash_ = other.hash_;
+                value_ = other.value_;
+                other.clear();
+                return *this;
             }
 
-            size_type _hash_to_index(size_t hash) const {
-                return hash % std::max(data_.size(), size_type(1));
+            void clear() {
+                hash_ = kDefaultHash;
+                value_ = nullptr;
             }
 
-            size_type _distance_to_ideal_bucket(size_type index) const {
-                size_type hashed_index = _hash_to_index(data_[index].hash());
+            const value_type &value() const {
+                return *value_;
+            }
 
-                if (hashed_index > index) {
-                    return data_.size() - hashed_index + index;
-                } else {
-                    return index - hashed_index;
-                }
+            value_type &value() {
+                return *value_;
             }
 
-            size_type _next_capacity(size_type needed_capacity) const {
-                size_type current_capacity = data_.size();
+            void make_sentinel() {
+                hash_ = kDefaultHash;
+                value_ = _sentinel_marker();
+            }
 
-                while (needed_capacity >= current_capacity) {
-                    current_capacity = traits_.next_capacity(current_capacity);
-                }
-                return current_capacity;
+            bool empty() const {
+                return value_ == nullptr;
             }
 
-            size_type _size_to_rehash() const {
-                return load_factor_ * data_.size();
+            bool sentinel() const {
+                return value_ == _sentinel_marker();
             }
 
-            void _rehash(size_type new_capacity) {
-                if (new_capacity > data_.size()) {
-                    hash_table rehashing_table(new_capacity, traits_, data_.get_allocator());
+            hash_type hash() const {
+                return hash_;
+            }
 
-                    for (auto &item: data_) {
-                        if (!item.empty()) {
-                            rehashing_table._insertion_helper(std::move(item));
-                            rehashing_table.size_++;
-                        }
-                    }
-                    rehashing_table.swap(*this);
-                }
+            void set_hash(hash_type hash) {
+                hash_ = hash;
             }
+        };
 
-            bool _try_to_rehash() {
-                if (size_ < _size_to_rehash()) {
-                    return false;
-                } else {
-                    _rehash(traits_.next_capacity(std::max(data_.size(), size_type(1))));
-                    return true;
-                }
+        template<typename TKey, typename TValue>
+        const TKey &key_of(const TValue &value) {
+            if constexpr (std::is_same_v<TValue, TKey>) {
+                return value;
+            } else {
+                return value.first;
             }
+        }
 
-            std::pair<size_type, bool> _find_spot(const key_type &key, size_t hash) const {
-                if (data_.empty()) {
-                    return std::make_pair(data_.size(), false);
-                }
+        // robin_hood_node without the stored hash. hash() recomputes it from the key with a default constructed
+        // KeyHash, which only pays off when that is about as cheap as loading a stored hash.
+        template<typename TValue, typename TKey, typename KeyHash>
+        class hashless_node {
+        public:
+            using hash_type = size_t;
+            using value_type = TValue;
+            using storage = detail::storage<TValue>;
 
-                size_type index = _hash_to_index(hash);
-                size_type distance = 0;
+            static constexpr const bool kRelocatable = is_trivially_relocatable<TValue>::value;
 
-                while (true) {
-                    if (data_[index].empty() ||
-                        distance > _distance_to_ideal_bucket(index)) {
-                        return std::make_pair(index, false);
-                    }
-                    if (data_[index].hash() == hash &&
-                        traits_(traits_.select_key(data_[index].value()), key)) {
-                        return std::make_pair(index, true);
-                    }
-                    index = _next_index(index);
-                    distance++;
-                }
-            }
+        private:
+            static const uint8_t kNoEmptyMarker = 1;
+            static const uint8_t kEmptyMarker = 0;
+            static const uint8_t kSentinelMarker = 2;
 
-            std::pair<size_type, bool> _find_spot(const key_type &key) const {
-                size_t hash = traits_(key);
-                return _find_spot(key, hash);
-            }
+            uint8_t empty_;
+            storage value_;
 
-            void _backward_shift(size_type index) {
-                size_type prior_index = index;
-                size_type current_index = _next_index(index);
+        public:
+            hashless_node()
+                    : empty_(kEmptyMarker) {}
 
-                data_[prior_index].clear();
-                while (!data_[current_index].empty() &&
-                       _distance_to_ideal_bucket(current_index) > 0) {
-                    data_[prior_index] = std::move(data_[current_index]);
-                    prior_index = current_index;
-                    current_index = _next_index(current_index);
-                }
+            template<typename ...Args>
+            explicit hashless_node(hash_type, Args &&...args)
+                    : empty_(kNoEmptyMarker) {
+                value_.construct(std::forward<Args>(args)...);
             }
 
-            size_type _erase(const key_type &key) {
-                auto spot_info = _find_spot(key);
+            hashless_node(const hashless_node &other) noexcept(std::is_nothrow_copy_constructible_v<value_type>)
+                    : empty_(other.empty_) {
+                if (other._has_value()) {
+                    value_.construct(*other.value_);
+                }
+            }
 
-                if (spot_info.second) {
-                    _backward_shift(spot_info.first);
-                    --size_;
-                    return 1;
+            hashless_node(hashless_node &&other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+                    : empty_(other.empty_) {
+                if (other._has_value()) {
+                    value_.construct(std::move(*other.value_));
                 }
-                return 0;
+                other.clear();
             }
 
-            void _insertion_helper(node &&insertion_node, size_type index) {
-                size_type ideal_pos = _hash_to_index(insertion_node.hash());
-                size_type distance = index - ideal_pos;
+            ~hashless_node() {
+                clear();
+            }
 
-                while (!data_[index].empty()) {
-                    if (_distance_to_ideal_bucket(index) < distance) {
-                        distance = _distance_to_ideal_bucket(index);
-                        data_[index].swap(insertion_node);
+            hashless_node &operator=(const hashless_node &other) {
+                if (this != &other) {
+                    clear();
+                    if (other._has_value()) {
+                        value_.construct(*other.value_);
                     }
-                    distance++;
-                    index = _next_index(index);
+                    empty_ = other.empty_;
                 }
-                data_[index].swap(insertion_node);
+                return *this;
             }
 
-            void _insertion_helper(node &&insertion_node) {
-                size_type index = _hash_to_index(insertion_node.hash());
-                _insertion_helper(std::move(insertion_node), index);
+            hashless_node &operator=(hashless_node &&other) noexcept(std::is_nothrow_move_constructible_v<value_type>) {
+                if (this != &other) {
+                    clear();
+                    if (other._has_value()) {
+                        value_.construct(std::move(*other.value_));
+                    }
+                    empty_ = other.empty_;
+                    other.clear();
+                }
+                return *this;
             }
 
-            std::pair<iterator, bool> _insert(const value_type &value) {
-                const key_type &key = traits_.select_key(value);
-                return _insert(key, value);
+            void clear() {
+                if (_has_value()) {
+                    value_.destruct();
+                }
+                empty_ = kEmptyMarker;
             }
 
-            std::pair<iterator, bool> _insert(value_type &&value) {
-                const key_type &key = traits_.select_key(value);
-                return _insert(key, reinterpret_cast<mutable_value_type &&>(std::move(value)));
+            const value_type &value() const {
+                return *value_;
             }
 
-            template<typename PKey, typename PValue>
-            std::pair<iterator, bool> _insert(PKey &&key, PValue &&value) {
-                size_t hash = traits_(std::forward<PKey>(key));
+            value_type &value() {
+                return *value_;
+            }
 
-                auto insertion_spot_info = _find_spot(std::forward<PKey>(key), hash);
+            void make_sentinel() {
+                clear();
+                empty_ = kSentinelMarker;
+            }
 
-                if (insertion_spot_info.second) {
-                    auto first = data_.data();
-                    auto last = data_.data() + data_.size();
-                    return std::make_pair(iterator(first + insertion_spot_info.first, first, last), true);
-                }
+            bool empty() const {
+                return empty_ == kEmptyMarker;
+            }
 
-                if (_try_to_rehash()) {
-                    insertion_spot_info = _find_spot(std::forward<PKey>(key), hash);
-                }
+            bool sentinel() const {
+                return empty_ == kSentinelMarker;
+            }
 
-                node insertion_node(hash, std::forward<PValue>(value));
-                _insertion_helper(std::move(insertion_node), insertion_spot_info.first);
-                size_++;
+            hash_type hash() const {
+                return KeyHash()(key_of<TKey>(*value_));
+            }
 
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
+            void set_hash(hash_type) {}
 
-                return std::make_pair(iterator(first + insertion_spot_info.first, first, last), false);
+        private:
+            bool _has_value() const {
+                return empty_ == kNoEmptyMarker;
             }
+        };
 
+        // stable_node that also keeps a copy of the key in the slot, so probes compare keys in the slot array and only
+        // follow the pointer once the key matched.
+        template<typename TValue, typename TKey>
+        class keyed_node {
         public:
-            hash_table() = default;
+            using hash_type = size_t;
+            using value_type = TValue;
+            using key_type = TKey;
 
-            explicit hash_table(size_type capacity,
-                                const hasher &key_hash_function = hasher{},
-                                const key_equal &key_equal_function = key_equal{},
-                                const allocator_type &allocator = allocator_type{})
-                    : data_(capacity, allocator),
-                      traits_(key_compare(key_hash_function, key_equal_function)) {
-            }
+            static constexpr const bool kRelocatable = is_trivially_relocatable<TKey>::value;
 
-            explicit hash_table(size_type capacity,
-                                const traits_type &traits,
-                                const allocator_type &allocator = allocator_type{})
-                    : data_(capacity, allocator),
-                      traits_(traits) {}
+        private:
+            stable_node<TValue> slot_;
+            storage<TKey> key_;
 
-            template<typename InputIt>
-            hash_table(InputIt begin, InputIt end,
-                       size_type capacity = 0,
-                       const hasher &key_hash_function = hasher{},
-                       const key_equal &key_equal_function = key_equal{},
-                       const allocator_type &allocator = allocator_type{})
-                    : data_(capacity, allocator),
-                      traits_(key_compare(key_hash_function, key_equal_function)) {
-                insert(begin, end);
+            bool _has_value() const {
+                return !slot_.empty() && !slot_.sentinel();
             }
 
-            hash_table(std::initializer_list<value_type> list,
-                       size_type capacity = 0,
-                       const hasher &key_hash_function = hasher{},
-                       const key_equal &key_equal_function = key_equal{},
-                       const allocator_type &allocator = allocator_type{})
-                    : data_(capacity, allocator),
-                      traits_(key_compare(key_hash_function, key_equal_function)) {
-                insert(list);
-            }
+        public:
+            keyed_node() = default;
 
-            hash_table(const hash_table &other)
-                    : data_(other.data_),
-                      size_(other.size_),
-                      load_factor_(other.load_factor_),
-                      traits_(other.traits_) {}
+            keyed_node(hash_type hash, value_type *value)
+                    : slot_(hash, value) {
+                key_.construct(key_of<TKey>(*value));
+            }
 
-            hash_table(const hash_table &other, const allocator_type &allocator)
-                    : data_(other.data_, allocator),
-                      size_(other.size_),
-                      load_factor_(other.load_factor_),
-                      traits_(other.traits_) {}
+            keyed_node(const keyed_node &other)
+                    : slot_(other.slot_) {
+                if (other._has_value()) {
+                    key_.construct(*other.key_);
+                }
+            }
 
-            hash_table(hash_table &&other) noexcept(
-            std::is_nothrow_move_constructible<traits_type>::value &&
-            std::is_nothrow_move_constructible<array>::value)
-                    : data_(std::move(other.data_)),
-                      size_(other.size_),
-                      load_factor_(other.load_factor_),
-                      traits_((std::move(other.traits_))) {
+            keyed_node(keyed_node &&other) noexcept(std::is_nothrow_move_constructible_v<TKey>)
+                    : slot_(other.slot_) {
+                if (other._has_value()) {
+                    key_.construct(std::move(*other.key_));
+                }
                 other.clear();
             }
 
-            hash_table(hash_table &&other, const allocator_type &allocator)
-                    : data_(std::move(other.data_), allocator),
-                      size_(other.size_),
-                      load_factor_(other.load_factor_),
-                      traits_((std::move(other.traits_))) {
-                other.clear();
+            ~keyed_node() {
+                clear();
             }
 
-            hash_table &operator=(const hash_table &other) {
-                if (this == &other) {
-                    return *this;
+            keyed_node &operator=(const keyed_node &other) {
+                if (this != &other) {
+                    clear();
+                    if (other._has_value()) {
+                        key_.construct(*other.key_);
+                    }
+                    slot_ = other.slot_;
                 }
-                data_ = other.data_;
-                size_ = other.size_;
-                load_factor_ = other.load_factor_;
-                traits_ = other.traits_;
                 return *this;
             }
 
-            hash_table &operator=(hash_table &&other) noexcept {
-                if (this == &other) {
-                    return *this;
+            keyed_node &operator=(keyed_node &&other) noexcept(std::is_nothrow_move_constructible_v<TKey>) {
+                if (this != &other) {
+                    clear();
+                    if (other._has_value()) {
+                        key_.construct(std::move(*other.key_));
+                    }
+                    slot_ = other.slot_;
+                    other.clear();
                 }
-                data_ = std::move(other.data_);
-                size_ = other.size_;
-                load_factor_ = other.load_factor_;
-                traits_ = std::move(other.traits_);
-                other.clear();
                 return *this;
             }
 
-            hash_table &operator=(std::initializer_list<value_type> list) noexcept {
-                clear();
-                insert(list);
-                return *this;
+            void clear() {
+                if (_has_value()) {
+                    key_.destruct();
+                }
+                slot_.clear();
             }
 
-            allocator_type get_allocator() const {
-                return data_.get_allocator();
+            const value_type &value() const {
+                return slot_.value();
             }
 
-            std::pair<iterator, bool> insert(const value_type &value) {
-                return _insert(value);
+            value_type &value() {
+                return slot_.value();
             }
 
-            std::pair<iterator, bool> insert(value_type &&value) {
-                return _insert(std::move(value));
+            const key_type &key() const {
+                return *key_;
             }
 
-            iterator insert(const_iterator hint, const value_type &value) {
-                (void) hint;
-                return _insert(value).first();
+            void make_sentinel() {
+                clear();
+                slot_.make_sentinel();
             }
 
-            iterator insert(const_iterator hint, value_type &&value) {
-                (void) hint;
-                return _insert(value).first();
+            bool empty() const {
+                return slot_.empty();
             }
 
-            template<typename InputIt>
-            void insert(InputIt begin, InputIt end) {
-                for (; begin != end; ++begin) {
-                    _insert(value_type(*begin));
-                }
+            bool sentinel() const {
+                return slot_.sentinel();
             }
 
-            void insert(std::initializer_list<value_type> list) {
-                insert(list.begin(), list.end());
+            hash_type hash() const {
+                return slot_.hash();
             }
 
-            template<typename ...Args>
-            std::pair<iterator, bool> emplace(Args ...args) {
-                return _insert(value_type(std::forward<Args>(args)...));
+            void set_hash(hash_type hash) {
+                slot_.set_hash(hash);
             }
+        };
 
-            template<typename ...Args>
-            iterator emplace_hint(const_iterator hint, Args ...args) {
-                (void) hint;
-                return _insert(value_type(std::forward<Args>(args)...)).first();
+        class no_value_pool {
+        public:
+            no_value_pool() = default;
+
+            template<typename Allocator>
+            explicit no_value_pool(const Allocator &) {}
+
+            size_t allocated_bytes() const noexcept {
+                return 0;
             }
 
-            iterator erase(iterator position) {
-                if (position == end()) {
-                    return end();
+            void clear() {}
+        };
+
+        // Hands out cells for stable_node values. Cells are carved from slabs that stay put until the pool is
+        // cleared or destroyed, released cells are reused through a free list.
+        template<typename TValue, typename Allocator>
+        class value_pool {
+            union cell {
+                cell *next;
+                storage<TValue> value;
+            };
+
+            using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<cell>;
+            using allocator_traits = std::allocator_traits<allocator_type>;
+            using slab = std::pair<cell *, size_t>;
+
+            static constexpr const size_t kFirstSlabSize = 16;
+            static constexpr const size_t kMaxSlabSize = 4096;
+
+            allocator_type allocator_;
+            std::vector<slab> slabs_;
+            cell *free_{nullptr};
+            size_t used_{0};
+
+            cell *_allocate() {
+                if (free_) {
+                    cell *item = free_;
+                    free_ = free_->next;
+                    return item;
                 }
-                _erase(traits_.select_key(*position));
-                if (position.data_->empty()) {
-                    ++position;
+                if (slabs_.empty() || used_ == slabs_.back().second) {
+                    size_t size = slabs_.empty() ? kFirstSlabSize : std::min(slabs_.back().second * 2, kMaxSlabSize);
+                    slabs_.emplace_back(nullptr, size);
+                    try {
+                        slabs_.back().first = allocator_traits::allocate(allocator_, size);
+                    } catch (...) {
+                        slabs_.pop_back();
+                        throw;
+                    }
+                    used_ = 0;
                 }
-                return position;
+                return slabs_.back().first + used_++;
             }
 
-            iterator erase(const_iterator position) {
-                return erase(mutable_iterator(position));
+            void _release(cell *item) {
+                item->next = free_;
+                free_ = item;
             }
 
-            iterator erase(const_iterator begin, const_iterator end) {
-                // TODO: Can be faster
-                for (; begin != end; ++begin) {
-                    erase(begin);
-                }
+        public:
+            value_pool() = default;
+
+            explicit value_pool(const Allocator &allocator)
+                    : allocator_(allocator) {}
+
+            value_pool(const value_pool &other) = delete;
+
+            value_pool(value_pool &&other) noexcept
+                    : allocator_(std::move(other.allocator_)),
+                      slabs_(std::move(other.slabs_)),
+                      free_(other.free_),
+                      used_(other.used_) {
+                other.slabs_.clear();
+                other.free_ = nullptr;
+                other.used_ = 0;
             }
 
-            size_type erase(const key_type &key) {
-                return _erase(key);
+            ~value_pool() {
+                clear();
             }
 
-            size_type count(const key_type &key) const {
-                auto spot_info = _find_spot(key);
-                if (spot_info.second) {
-                    return 1;
-                } else {
-                    return 0;
+            value_pool &operator=(const value_pool &other) = delete;
+
+            value_pool &operator=(value_pool &&other) noexcept {
+                if (this != &other) {
+                    clear();
+                    allocator_ = std::move(other.allocator_);
+                    slabs_ = std::move(other.slabs_);
+                    free_ = other.free_;
+                    used_ = other.used_;
+                    other.slabs_.clear();
+                    other.free_ = nullptr;
+                    other.used_ = 0;
                 }
+                return *this;
             }
 
-            // TODO: One more methods of 'count'
-
-            iterator find(const key_type &key) {
-                return mutable_iterator(static_cast<const hash_table *>(this)->find(key));
+            template<typename ...Args>
+            TValue *create(Args &&...args) {
+                cell *item = _allocate();
+                try {
+                    item->value.construct(std::forward<Args>(args)...);
+                } catch (...) {
+                    _release(item);
+                    throw;
+                }
+                return &*item->value;
             }
 
-            const_iterator find(const key_type &key) const {
-                auto spot_info = _find_spot(key);
+            void destroy(TValue *value) {
+                value->~TValue();
+                _release(reinterpret_cast<cell *>(value));
+            }
 
-                if (!spot_info.second) {
-                    return end();
+            size_t allocated_bytes() const noexcept {
+                size_t cells = 0;
+                for (const auto &item: slabs_) {
+                    cells += item.second;
                 }
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
+                return cells * sizeof(cell);
+            }
 
-                return const_iterator(first + spot_info.first, first, last);
+            // Every value must have been destroyed already.
+            void clear() {
+                for (auto &item: slabs_) {
+                    allocator_traits::deallocate(allocator_, item.first, item.second);
+                }
+                slabs_.clear();
+                free_ = nullptr;
+                used_ = 0;
             }
+        };
 
-            //TODO: Two more methods of find
 
-            bool contains(const key_type &key) const {
-                return count(key) == 1;
-            }
+        template<typename TNode, typename Allocator = std::allocator<TNode>>
+        class node_array {
+            using nodes = array<TNode, Allocator>;
 
-            // TODO: One more methods of 'contains'
+        public:
+            using allocator_type = typename nodes::allocator_type;
+            using value_type = typename nodes::value_type;
+            using difference_type = typename nodes::difference_type;
+            using reference = typename nodes::reference;
+            using const_reference = typename nodes::const_reference;
+            using pointer = typename nodes::pointer;
+            using const_pointer = typename nodes::const_pointer;
+            using size_type = typename nodes::size_type;
 
-            std::pair<iterator, iterator> equal_range(const key_type &key) {
-                iterator founded = find(key);
-                return std::make_pair(founded, std::next(founded));
+        private:
+            static constexpr const size_type kSentinels = 2;
+            static constexpr const bool kRelocatable = TNode::kRelocatable;
+
+            nodes nodes_;
+
+        private:
+            void _make_sentinels() {
+                if (!nodes_.empty()) {
+                    nodes_[0].make_sentinel();
+                    nodes_[nodes_.size() - 1].make_sentinel();
+                }
             }
 
-            std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
-                const_iterator founded = find(key);
-                return std::make_pair(founded, std::next(founded));
+        public:
+            node_array() = default;
+
+            explicit node_array(const allocator_type &allocator)
+                    : nodes_(allocator) {}
+
+            node_array(size_type size, const allocator_type &allocator)
+                    : nodes_(size == 0 ? 0 : size + kSentinels, allocator) {
+                _make_sentinels();
             }
 
-            //TODO: Two more methods of equal_range
+            node_array(const node_array &other, const allocator_type &allocator)
+                    : nodes_(other.nodes_, allocator) {}
 
-            size_type bucket_count() const {
-                return size_;
+            node_array(node_array &&other, const allocator_type &allocator)
+                    : nodes_(std::move(other.nodes_), allocator) {}
+
+            void clear() {
+                nodes_.clear();
             }
 
-            size_type max_bucket_count() const {
-                return data_.size();
+            pointer data() noexcept {
+                return nodes_.empty() ? nullptr : nodes_.data() + 1;
             }
 
-            float load_factor() const {
-                return static_cast<float>(size_) / static_cast<float>(data_.size());
+            const_pointer data() const noexcept {
+                return nodes_.empty() ? nullptr : nodes_.data() + 1;
             }
 
-            float max_load_factor() const {
-                return load_factor_;
+            reference operator[](size_type index) {
+                return nodes_[index + 1];
             }
 
-            void max_load_factor(float load_factor) {
-                load_factor_ = std::min(1.f, load_factor);
+            const_reference operator[](size_type index) const {
+                return nodes_[index + 1];
             }
 
-            void rehash(size_type new_capacity) {
-                reserve(new_capacity);
+            allocator_type get_allocator() const {
+                return nodes_.get_allocator();
             }
 
-            void reserve(size_type new_capacity) {
-                size_type next_capacity = _next_capacity(new_capacity);
+            bool empty() const noexcept {
+                return nodes_.empty();
+            }
 
-                if (new_capacity > data_.size()) {
-                    _rehash(next_capacity);
-                }
+            size_type size() const noexcept {
+                return nodes_.empty() ? 0 : nodes_.size() - kSentinels;
             }
 
-            hasher hash_function() const {
-                return traits_.hash_function();
+            size_type allocated_bytes() const noexcept {
+                return nodes_.size() * sizeof(value_type);
             }
 
-            key_equal key_eq() const {
-                return traits_.key_eq();
+            void reallocate(size_type size) {
+                size_type last = nodes_.size() - 1;
+                nodes_.reallocate(size + kSentinels);
+                nodes_[last].clear();
+                _make_sentinels();
             }
 
-            bool operator==(const hash_table &other) const {
-                if (other.size() != size()) {
-                    return false;
-                }
-                for (auto it = other.begin(); it != other.end(); ++it) {
-                    if (!contains(other.traits_.select_key(*it))) {
-                        return false;
+            // Moves [first, last) one slot up, the node at last must be empty and the one at first is left empty.
+            void shift_up(size_type first, size_type last) {
+                if constexpr (kRelocatable) {
+                    if (first != last) {
+                        std::memmove(static_cast<void *>(data() + first + 1), static_cast<const void *>(data() + first),
+                                     (last - first) * sizeof(value_type));
+                        (*this)[first].clear();
+                    }
+                } else {
+                    for (size_type index = last; index > first; --index) {
+                        (*this)[index] = std::move((*this)[index - 1]);
                     }
                 }
-                return true;
             }
 
-            bool operator!=(const hash_table &other) const {
-                return !this->operator==(other);
+            // Moves (first, last) one slot down, the node at first must be empty and the one before last is left empty.
+            void shift_down(size_type first, size_type last) {
+                if constexpr (kRelocatable) {
+                    if (last - first > 1) {
+                        std::memmove(static_cast<void *>(data() + first), static_cast<const void *>(data() + first + 1),
+                                     (last - first - 1) * sizeof(value_type));
+                        (*this)[last - 1].clear();
+                    }
+                } else {
+                    for (size_type index = first; index + 1 < last; ++index) {
+                        (*this)[index] = std::move((*this)[index + 1]);
+                    }
+                }
             }
 
-            void clear() {
-                data_.clear();
-                size_ = 0;
+            pointer begin() noexcept {
+                return data();
             }
 
-            void swap(hash_table &other) {
-                std::swap(traits_, other.traits_);
-                std::swap(load_factor_, other.load_factor_);
-                std::swap(size_, other.size_);
-                std::swap(data_, other.data_);
+            pointer end() noexcept {
+                return data() + size();
             }
 
-            bool empty() const {
-                return size_ == 0;
+            const_pointer begin() const noexcept {
+                return data();
             }
 
-            size_type size() const {
-                return size_;
+            const_pointer end() const noexcept {
+                return data() + size();
             }
+        };
 
-            iterator mutable_iterator(const_iterator position) {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                return iterator(const_cast<node_pointer>(position.data_), first, last);
+        struct hash_table_stats {
+            size_t size{0};
+            size_t bucket_count{0};
+            std::vector<size_t> probe_histogram;
+            double mean_displacement{0};
+            size_t max_displacement{0};
+            size_t longest_cluster{0};
+            double empty_fraction{1};
+            double bytes_per_element{0};
+        };
+
+        struct rehash_event {
+            enum class phase {
+                before,
+                after
+            };
+
+            phase when{phase::before};
+            size_t old_capacity{0};
+            size_t new_capacity{0};
+            size_t size{0};
+            size_t old_bytes{0};
+            size_t new_bytes{0};
+            std::chrono::steady_clock::duration elapsed{};
+        };
+
+        // Base of hash_table that holds its instrumentation. Probes are const, so the hooks are reached through a
+        // mutable member; an empty instrumentation is an empty base instead and takes no space.
+        template<typename Instrumentation,
+                bool = std::is_empty_v<Instrumentation> && !std::is_final_v<Instrumentation>>
+        class instrumentation_holder {
+            mutable Instrumentation instrumentation_;
+
+        protected:
+            Instrumentation &_instrumentation() const {
+                return instrumentation_;
             }
+        };
 
-            iterator begin() noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                auto current = first;
-                while (current->empty() && current != last) {
-                    ++current;
+        template<typename Instrumentation>
+        class instrumentation_holder<Instrumentation, true> : private Instrumentation {
+        protected:
+            Instrumentation &_instrumentation() const {
+                return const_cast<instrumentation_holder &>(*this);
+            }
+        };
+
+        template<typename Traits, typename Instrumentation = no_instrumentation>
+        class hash_table : private instrumentation_holder<Instrumentation> {
+            template<class, class>
+            friend class segmented_hash_table;
+
+            template<typename TItem>
+            class hash_table_iterator;
+
+            template<typename TIterator>
+            class hash_table_range;
+
+            class hash_table_entry;
+
+            class hash_table_cursor;
+
+            using traits_type = Traits;
+            using key_compare = typename Traits::key_compare;
+            using storage_policy = typename Traits::storage_policy;
+            using node = typename storage_policy::template node_type<typename Traits::mutable_value_type,
+                    typename Traits::key_type>;
+            using value_pool = typename storage_policy::template pool_type<typename Traits::mutable_value_type,
+                    typename Traits::allocator_type>;
+            using node_allocator = typename std::allocator_traits<typename Traits::allocator_type>::template rebind_alloc<node>;
+            using array = node_array<node, node_allocator>;
+            using node_pointer = typename array::pointer;
+            using bitmap = detail::bitmap<typename Traits::allocator_type>;
+            using bitmap_allocator = typename bitmap::allocator_type;
+            using instrumentation_base = instrumentation_holder<Instrumentation>;
+
+            static constexpr bool _node_hash_matches() {
+                if constexpr (storage_policy::kStoresHash) {
+                    return true;
+                } else {
+                    return std::is_same_v<typename storage_policy::key_hash, typename Traits::hasher> &&
+                           std::is_empty_v<typename Traits::hasher>;
                 }
-                return iterator(current, first, last);
             }
 
-            iterator end() noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                return iterator(last, first, last);
+            static_assert(_node_hash_matches(), "hashless_storage must recompute hashes with the table's stateless hasher");
+
+            static constexpr const float kMinLoadFactor = 0.1f;
+            static constexpr const float kMaxLoadFactor = 0.95f;
+            static constexpr const float kDefaultLoadFactor = LD_ROBIN_HOOD_DEFAULT_LOAD_FACTOR;
+
+            static_assert(kDefaultLoadFactor >= kMinLoadFactor && kDefaultLoadFactor <= kMaxLoadFactor,
+                          "LD_ROBIN_HOOD_DEFAULT_LOAD_FACTOR must be in [0.1, 0.95]");
+            static constexpr const size_t kFloodProbeLength = 128;
+
+        public:
+            using value_type = typename Traits::value_type;
+            using mutable_value_type = typename Traits::mutable_value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = typename Traits::value_type &;
+            using const_reference = const typename Traits::value_type &;
+            using pointer = typename Traits::value_type *;
+            using const_pointer = const typename Traits::value_type *;
+
+            using key_type = typename key_compare::key_type;
+            using key_equal = typename key_compare::key_equal;
+            using hasher = typename key_compare::hasher;
+
+            using iterator = hash_table_iterator<value_type>;
+            using const_iterator = hash_table_iterator<const value_type>;
+
+            using range = hash_table_range<iterator>;
+            using const_range = hash_table_range<const_iterator>;
+
+            using entry = hash_table_entry;
+
+            using cursor = hash_table_cursor;
+
+            using stats_type = hash_table_stats;
+
+            using instrumentation_type = Instrumentation;
+
+            using rehash_event = detail::rehash_event;
+            using rehash_observer = std::function<void(const rehash_event &)>;
+
+            using allocator_type = typename Traits::allocator_type;
+
+            using size_type = typename array::size_type;
+
+        private:
+            traits_type traits_;
+
+            float load_factor_{kDefaultLoadFactor};
+            size_type size_{0};
+            array data_;
+            value_pool pool_;
+            bitmap occupied_;
+            rehash_observer rehash_observer_;
+            size_type reseeded_capacity_{0};
+
+        private:
+            instrumentation_type &_instrumentation() const {
+                return instrumentation_base::_instrumentation();
             }
 
-            iterator begin() const noexcept {
-                return cbegin();
+            size_type _next_index(size_type index) const {
+                ++index;
+                return index == data_.size() ? 0 : index;
             }
 
-            const_iterator end() const noexcept {
-                return cend();
+            size_type _hash_to_index(size_t hash) const {
+                return traits_.hash_to_index(hash, std::max(data_.size(), size_type(1)));
             }
 
-            const_iterator cbegin() const noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                auto current = first;
-                while (current->empty() && current != last) {
-                    ++current;
+            size_type _distance_to_ideal_bucket(size_type index) const {
+                size_type hashed_index = _hash_to_index(data_[index].hash());
+
+                if (hashed_index > index) {
+                    return data_.size() - hashed_index + index;
+                } else {
+                    return index - hashed_index;
                 }
-                return const_iterator(current, first, last);
             }
 
-            const_iterator cend() const noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                return const_iterator(last, first, last);
+            size_type _first_occupied(size_type index) const {
+                return occupied_.find_next(index, data_.size());
             }
 
-            iterator rbegin() noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                auto current = last;
-                while (current->empty() && current != first - 1) {
-                    --current;
+            iterator _iterator_at(difference_type index) {
+                if (data_.empty()) {
+                    return iterator();
                 }
-                return iterator(current, first, last);
+                return iterator(data_.data() + index);
             }
 
-            iterator rend() noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                return iterator(first - 1, first, last);
+            const_iterator _const_iterator_at(difference_type index) const {
+                if (data_.empty()) {
+                    return const_iterator();
+                }
+                return const_iterator(data_.data() + index);
             }
 
-            const_iterator rbegin() const noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                auto current = last;
-                while (current->empty() && current != first - 1) {
-                    --current;
+            std::vector<size_type> _split_bounds(size_type count) const {
+                size_type parts = std::max(size_type(1), std::min(count, data_.size()));
+                std::vector<size_type> bounds;
+                bounds.reserve(parts + 1);
+                bounds.push_back(_first_occupied(0));
+                for (size_type i = 1; i <= parts; ++i) {
+                    bounds.push_back(_first_occupied(std::max(bounds.back(), data_.size() * i / parts)));
                 }
-                return const_iterator(current, first, last);
+                return bounds;
             }
 
-            const_iterator rend() const noexcept {
-                auto first = data_.data();
-                auto last = data_.data() + data_.size();
-                return const_iterator(first - 1, first, last);
+            static size_type _default_split_count() {
+                return std::max(size_type(1), size_type(std::thread::hardware_concurrency()));
             }
 
-        private:
-            template<typename TItem>
-            class hash_table_iterator {
-                friend class hash_table;
-
-            public:
-                using iterator_category = std::bidirectional_iterator_tag;
-                using value_type = TItem;
-                using difference_type = std::ptrdiff_t;
-                using reference = value_type &;
-                using pointer = value_type *;
-
-            private:
-                using node_pointer = typename std::conditional<std::is_const<TItem>::value, const node *, node *>::type;
+            size_type _next_capacity(size_type needed_capacity) const {
+                return traits_.capacity_for(needed_capacity, data_.size());
+            }
 
-            private:
-                node_pointer first_;
-                node_pointer last_;
-                node_pointer data_;
+            size_type _size_to_rehash() const {
+                size_type capacity = data_.size();
+                if (capacity == 0) {
+                    return 0;
+                }
+                return std::min(static_cast<size_type>(load_factor_ * capacity), capacity - 1);
+            }
 
-                explicit hash_table_iterator(node_pointer data, node_pointer first, node_pointer last)
-                        : first_(first),
-                          last_(last),
-                          data_(data) {}
+            // Slot array and bitmap at the given capacity, plus the value slabs, which a rehash leaves alone.
+            size_type _allocated_bytes(size_type capacity) const {
+                return (capacity == 0 ? 0 : (capacity + 2) * sizeof(node)) +
+                       (capacity + bitmap::kWordBits - 1) / bitmap::kWordBits * sizeof(typename bitmap::word_type) +
+                       pool_.allocated_bytes();
+            }
 
-            public:
-                hash_table_iterator()
-                        : first_(nullptr),
-                          last_(nullptr),
-                          data_(nullptr) {}
+            void _notify_rehash(rehash_event::phase when, size_type old_capacity, size_type new_capacity,
+                                std::chrono::steady_clock::duration elapsed) {
+                rehash_event event;
+                event.when = when;
+                event.old_capacity = old_capacity;
+                event.new_capacity = new_capacity;
+                event.size = size_;
+                event.old_bytes = _allocated_bytes(old_capacity);
+                event.new_bytes = _allocated_bytes(new_capacity);
+                event.elapsed = elapsed;
+                rehash_observer_(event);
+            }
 
-                hash_table_iterator(const hash_table_iterator &other)
-                        : first_(other.first_),
-                          last_(other.last_),
-                          data_(other.data_) {}
+            static constexpr bool _supports_in_place_growth() {
+                return has_reallocate<node_allocator>::value && node::kRelocatable;
+            }
 
+            static bool _is_doubling(size_type old_capacity, size_type new_capacity) {
+                return has_modulo_index<typename Traits::growth_policy>::value &&
+                       old_capacity != 0 && new_capacity == old_capacity * 2;
+            }
 
-                hash_table_iterator &operator=(const hash_table_iterator &other) {
-                    first_ = other.first_;
-                    last_ = other.last_;
-                    data_ = other.data_;
-                    return *this;
+            size_type _first_empty() const {
+                size_type index = 0;
+                while (!data_[index].empty()) {
+                    ++index;
                 }
+                return index;
+            }
 
-            public:
-                reference operator*() const {
-                    return reinterpret_cast<reference>(data_->value());
+            size_type _wrapped_prefix(size_type start) const {
+                size_type wrapped = 0;
+                while (wrapped < start && !data_[wrapped].empty() &&
+                       traits_.hash_to_index(data_[wrapped].hash(), data_.size()) > wrapped) {
+                    ++wrapped;
                 }
+                return wrapped;
+            }
 
-                pointer operator->() const {
-                    return reinterpret_cast<pointer>(&data_->value());
-                }
+            // Read from an empty slot onwards the old array is ordered by home, and doubling splits it into a lower
+            // and an upper half that keep that order, so each half is written sequentially behind its own cursor.
+            // The few elements that would run past the end of their half are placed by the regular insertion.
+            void _rehash_streaming(size_type new_capacity) {
+                size_type old_capacity = data_.size();
+                size_type start = _first_empty();
+                size_type wrapped = _wrapped_prefix(start);
+
+                hash_table rehashing_table(new_capacity, traits_, data_.get_allocator());
+                std::vector<node, node_allocator> overflow(data_.get_allocator());
+                size_type cursors[2] = {0, old_capacity};
+                auto stream = [&](size_type from) {
+                    node &item = data_[from];
+                    if (item.empty()) {
+                        return;
+                    }
+                    size_type home = rehashing_table._hash_to_index(item.hash());
+                    bool upper = home >= old_capacity;
+                    size_type to = std::max(home, cursors[upper]);
+                    if (to >= (upper ? new_capacity : old_capacity)) {
+                        overflow.push_back(std::move(item));
+                        return;
+                    }
+                    rehashing_table.data_[to] = std::move(item);
+                    rehashing_table.occupied_.set(to);
+                    cursors[upper] = to + 1;
+                };
 
-                bool operator==(const hash_table_iterator &other) const {
-                    return first_ == other.first_ && last_ == other.last_ && data_ == other.data_;
+                for (size_type from = wrapped; from < start; ++from) {
+                    stream(from);
                 }
-
-                bool operator!=(const hash_table_iterator &other) const {
-                    return first_ != other.first_ || last_ != other.last_ || data_ != other.data_;
+                for (size_type from = start + 1; from < old_capacity; ++from) {
+                    stream(from);
                 }
-
-                hash_table_iterator &operator++() {
-                    go_next();
-                    return *this;
+                for (size_type from = 0; from < wrapped; ++from) {
+                    stream(from);
                 }
-
-                hash_table_iterator operator++(int) {
-                    hash_table_iterator result = *this;
-                    go_next();
-                    return result;
+                for (auto &item: overflow) {
+                    rehashing_table._insertion_helper(std::move(item));
                 }
+                std::swap(data_, rehashing_table.data_);
+                std::swap(occupied_, rehashing_table.occupied_);
+            }
 
-                hash_table_iterator &operator--() {
-                    go_prior();
-                    return *this;
+            // Doubling under modulo reduction keeps each home or moves it up by the old capacity: the lower half is
+            // compacted in place starting after an empty slot, the elements moving up are reinserted afterwards.
+            void _grow_in_place(size_type new_capacity) {
+                size_type old_capacity = data_.size();
+                size_type start = _first_empty();
+                size_type wrapped = _wrapped_prefix(start);
+
+                data_.reallocate(new_capacity);
+
+                std::vector<node, node_allocator> moved_up(data_.get_allocator());
+                size_type cursor = 0;
+                auto place = [&](size_type from) {
+                    size_type home = _hash_to_index(data_[from].hash());
+                    if (home >= old_capacity) {
+                        moved_up.push_back(std::move(data_[from]));
+                        return;
+                    }
+                    size_type to = std::max(home, cursor);
+                    if (to != from) {
+                        data_[to] = std::move(data_[from]);
+                    }
+                    cursor = to + 1;
+                };
+
+                cursor = start + 1;
+                for (size_type from = start + 1; from < old_capacity; ++from) {
+                    if (!data_[from].empty()) {
+                        place(from);
+                    }
+                }
+                for (size_type from = 0; from < wrapped; ++from) {
+                    place(from);
+                }
+                cursor = 0;
+                for (size_type from = wrapped; from < start; ++from) {
+                    if (!data_[from].empty()) {
+                        place(from);
+                    }
                 }
 
-                hash_table_iterator operator--(int) {
-                    hash_table_iterator result = *this;
-                    go_prior();
-                    return result;
+                occupied_ = bitmap(new_capacity, data_.get_allocator());
+                for (size_type index = 0; index < new_capacity; ++index) {
+                    if (!data_[index].empty()) {
+                        occupied_.set(index);
+                    }
+                }
+                for (auto &item: moved_up) {
+                    _insertion_helper(std::move(item));
                 }
+            }
 
-            private:
-                void go_next() {
-                    while (true) {
-                        data_++;
-                        if (data_ == last_ || !data_->empty()) {
-                            return;
-                        }
+            void _rehash_out_of_place(size_type new_capacity) {
+                hash_table rehashing_table(new_capacity, traits_, data_.get_allocator());
+
+                for (auto &item: data_) {
+                    if (!item.empty()) {
+                        rehashing_table._insertion_helper(std::move(item));
                     }
                 }
+                std::swap(data_, rehashing_table.data_);
+                std::swap(occupied_, rehashing_table.occupied_);
+            }
 
-                void go_prior() {
-                    while (true) {
-                        data_--;
-                        if (data_ == first_ - 1 || !data_->empty()) {
-                            return;
+            void _rehash(size_type new_capacity) {
+                if (new_capacity > data_.size()) {
+                    size_type old_capacity = data_.size();
+                    _instrumentation().rehash_begin(old_capacity, new_capacity, size_);
+
+                    std::chrono::steady_clock::time_point start;
+                    if (rehash_observer_) {
+                        _notify_rehash(rehash_event::phase::before, old_capacity, new_capacity, {});
+                        start = std::chrono::steady_clock::now();
+                    }
+
+                    if (_is_doubling(old_capacity, new_capacity)) {
+                        if constexpr (_supports_in_place_growth()) {
+                            _grow_in_place(new_capacity);
+                        } else {
+                            _rehash_streaming(new_capacity);
                         }
+                    } else {
+                        _rehash_out_of_place(new_capacity);
                     }
-                }
-            };
-        };
-    }
 
-    class power_of_two_growth_policy {
-    public:
-        using size_type = size_t;
-    public:
-        size_type operator()(size_type current) const {
-            return current * 2;
-        }
-    };
+                    _instrumentation().rehash_end(old_capacity, new_capacity, size_);
 
-    class prime_growth_policy {
-    public:
-        using size_type = size_t;
-    public:
-        size_type operator()(size_type current) const {
-            for (const auto &item: detail::PRIMES) {
-                if (current < item) {
-                    return item;
+                    if (rehash_observer_) {
+                        _notify_rehash(rehash_event::phase::after, old_capacity, new_capacity,
+                                       std::chrono::steady_clock::now() - start);
+                    }
                 }
             }
-            return current;
-        }
-    };
 
-    template<class TKey,
-            class KeyHash,
-            class KeyEqual>
-    class key_compare_traits {
-    public:
-        using key_type = TKey;
-        using hasher = KeyHash;
-        using key_equal = KeyEqual;
+            bool _try_to_rehash() {
+                if (size_ < _size_to_rehash()) {
+                    return false;
+                } else {
+                    _rehash(traits_.next_capacity(std::max(data_.size(), size_type(1))));
+                    return true;
+                }
+            }
 
-    private:
-        hasher key_hash_;
-        key_equal key_equal_;
+            // Reported to instrumentation and the rehash observer as a rehash to the same capacity.
+            size_type _reseed(size_type tracked_index) {
+                size_type capacity = data_.size();
+                _instrumentation().rehash_begin(capacity, capacity, size_);
 
-    public:
-        key_compare_traits() = default;
+                std::chrono::steady_clock::time_point start;
+                if (rehash_observer_) {
+                    _notify_rehash(rehash_event::phase::before, capacity, capacity, {});
+                    start = std::chrono::steady_clock::now();
+                }
 
-        explicit key_compare_traits(const hasher &key_hash_arg) noexcept(
-        std::is_nothrow_copy_constructible_v<hasher> &&
-        std::is_nothrow_default_constructible_v<key_equal>)
-                : key_hash_(key_hash_arg), key_equal_() {}
+                traits_.reseed(detail::random_seed());
+                reseeded_capacity_ = data_.size();
 
-        explicit key_compare_traits(const key_equal &key_equal_arg) noexcept(
-        std::is_nothrow_copy_constructible_v<key_equal> &&
-        std::is_nothrow_default_constructible_v<hasher>)
-                : key_hash_(), key_equal_(key_equal_arg) {}
+                hash_table reseeded_table(data_.size(), traits_, data_.get_allocator());
+                for (size_type index = 0; index < data_.size(); ++index) {
+                    if (index != tracked_index && !data_[index].empty()) {
+                        node item(std::move(data_[index]));
+                        item.set_hash(traits_(traits_.select_key(item.value())));
+                        reseeded_table._insertion_helper(std::move(item));
+                    }
+                }
 
-        key_compare_traits(const hasher &key_hash_arg, const key_equal &key_equal_arg) noexcept(
-        std::is_nothrow_copy_constructible_v<hasher> &&
-        std::is_nothrow_copy_constructible_v<key_equal>)
-                : key_hash_(key_hash_arg), key_equal_(key_equal_arg) {}
+                node tracked(std::move(data_[tracked_index]));
+                tracked.set_hash(traits_(traits_.select_key(tracked.value())));
+                tracked_index = reseeded_table._find_spot(traits_.select_key(tracked.value()), tracked.hash()).first;
+                reseeded_table._insertion_helper(std::move(tracked), tracked_index);
 
-        key_compare_traits(const key_compare_traits &other) noexcept(
-        std::is_nothrow_copy_constructible_v<hasher> &&
-        std::is_nothrow_copy_constructible_v<key_equal>) = default;
+                std::swap(data_, reseeded_table.data_);
+                std::swap(occupied_, reseeded_table.occupied_);
+
+                _instrumentation().rehash_end(capacity, capacity, size_);
+
+                if (rehash_observer_) {
+                    _notify_rehash(rehash_event::phase::after, capacity, capacity,
+                                   std::chrono::steady_clock::now() - start);
+                }
+                return tracked_index;
+            }
+
+            size_type _try_to_reseed(size_type probe_length, size_type index) {
+                if constexpr (detail::is_reseedable<hasher>::value) {
+                    if (probe_length > kFloodProbeLength && reseeded_capacity_ != data_.size()) {
+                        return _reseed(index);
+                    }
+                }
+                return index;
+            }
+
+            template<typename PKey>
+            std::pair<size_type, bool> _find_spot(const PKey &key, size_t hash) const {
+                if (data_.empty()) {
+                    _instrumentation().lookup(false, 0);
+                    return std::make_pair(data_.size(), false);
+                }
+
+                size_type index = _hash_to_index(hash);
+                size_type distance = 0;
+
+                while (true) {
+                    if (data_[index].empty() ||
+                        distance > _distance_to_ideal_bucket(index)) {
+                        _instrumentation().lookup(false, distance);
+                        return std::make_pair(index, false);
+                    }
+                    if (data_[index].hash() == hash &&
+                        traits_(_node_key(data_[index]), key)) {
+                        _instrumentation().lookup(true, distance);
+                        return std::make_pair(index, true);
+                    }
+                    index = _next_index(index);
+                    distance++;
+                }
+            }
+
+            template<typename PKey>
+            std::pair<size_type, bool> _find_spot(const PKey &key) const {
+                size_t hash = traits_(key);
+                return _find_spot(key, hash);
+            }
+
+            // Keys of another type are only probed with directly when the hasher and the key comparison are both
+            // transparent, otherwise they are converted once up front.
+            template<typename PKey>
+            static constexpr bool _is_lookup_key() {
+                return key_compare::kTransparent || std::is_same_v<std::decay_t<PKey>, key_type>;
+            }
+
+            template<typename PKey>
+            std::pair<size_type, bool> _find_lookup_spot(const PKey &key) const {
+                if constexpr (_is_lookup_key<PKey>()) {
+                    return _find_spot(key);
+                } else {
+                    return _find_spot(key_type(key));
+                }
+            }
+
+            const key_type &_node_key(const node &item) const {
+                if constexpr (storage_policy::kKeysInSlots) {
+                    return item.key();
+                } else {
+                    return traits_.select_key(item.value());
+                }
+            }
+
+            template<typename ...Args>
+            node _make_node(size_t hash, Args &&...args) {
+                if constexpr (storage_policy::kStableValues) {
+                    return node(hash, pool_.create(std::forward<Args>(args)...));
+                } else {
+                    return node(hash, std::forward<Args>(args)...);
+                }
+            }
+
+            void _destroy_value(node &item) {
+                if constexpr (storage_policy::kStableValues) {
+                    pool_.destroy(&item.value());
+                }
+            }
+
+            void _destroy_values() {
+                if constexpr (storage_policy::kStableValues) {
+                    if (size_ != 0) {
+                        for (auto &item: data_) {
+                            if (!item.empty()) {
+                                _destroy_value(item);
+                                item.clear();
+                            }
+                        }
+                    }
+                }
+            }
+
+            // A copied array still points at the values of the source table.
+            void _clone_values() {
+                if constexpr (storage_policy::kStableValues) {
+                    auto item = data_.begin();
+                    try {
+                        for (; item != data_.end(); ++item) {
+                            if (!item->empty()) {
+                                *item = node(item->hash(), pool_.create(item->value()));
+                            }
+                        }
+                    } catch (...) {
+                        for (; item != data_.end(); ++item) {
+                            item->clear();
+                        }
+                        clear();
+                        throw;
+                    }
+                }
+            }
+
+            void _shift_up(size_type first, size_type last) {
+                if (first <= last) {
+                    data_.shift_up(first, last);
+                } else {
+                    data_.shift_up(0, last);
+                    data_[0] = std::move(data_[data_.size() - 1]);
+                    data_.shift_up(first, data_.size() - 1);
+                }
+            }
+
+            void _shift_down(size_type first, size_type last) {
+                if (first < last) {
+                    data_.shift_down(first, last);
+                } else {
+                    data_.shift_down(first, data_.size());
+                    if (last != 0) {
+                        data_[data_.size() - 1] = std::move(data_[0]);
+                        data_.shift_down(0, last);
+                    }
+                }
+            }
+
+            // Returns the first slot that did not move.
+            size_type _backward_shift(size_type index) {
+                size_type last = _next_index(index);
+                size_type length = 0;
+
+                while (!data_[last].empty() && _distance_to_ideal_bucket(last) > 0) {
+                    last = _next_index(last);
+                    length++;
+                }
+                _destroy_value(data_[index]);
+                data_[index].clear();
+                _shift_down(index, last);
+                occupied_.reset(last == 0 ? data_.size() - 1 : last - 1);
+                _instrumentation().backward_shift(length);
+                return last;
+            }
+
+            size_type _erase(const key_type &key) {
+                size_t hash = traits_(key);
+                return _erase(key, hash);
+            }
+
+            size_type _erase(const key_type &key, size_t hash) {
+                auto spot_info = _find_spot(key, hash);
+
+                if (spot_info.second) {
+                    _erase_at(spot_info.first);
+                    return 1;
+                }
+                return 0;
+            }
+
+            // Moves the nodes that match predicate into sink and closes the gaps, walking the array like erase_if.
+            template<typename Predicate, typename Sink>
+            void _extract_if(Predicate predicate, Sink sink) {
+                if (size_ == 0) {
+                    return;
+                }
+                size_type start = _first_empty();
+                size_type index = _next_index(start);
+                while (index != start) {
+                    if (!data_[index].empty() && predicate(data_[index])) {
+                        sink(std::move(data_[index]));
+                        _erase_at(index);
+                    } else {
+                        index = _next_index(index);
+                    }
+                }
+            }
+
+            size_type _erase_at(size_type index) {
+                size_type last = _backward_shift(index);
+                --size_;
+                return last;
+            }
+
+            size_type _insertion_helper(node &&insertion_node, size_type index) {
+                size_type ideal_pos = _hash_to_index(insertion_node.hash());
+                size_type distance = index >= ideal_pos ? index - ideal_pos : data_.size() - ideal_pos + index;
+                size_type displacement = 0;
+
+                while (!data_[index].empty() && _distance_to_ideal_bucket(index) >= distance) {
+                    distance++;
+                    index = _next_index(index);
+                    displacement++;
+                }
+                size_type probe_length = distance;
+                size_type last = index;
+                while (!data_[last].empty()) {
+                    probe_length = std::max(probe_length, _distance_to_ideal_bucket(last) + 1);
+                    last = _next_index(last);
+                    displacement++;
+                }
+                _shift_up(index, last);
+                data_[index] = std::move(insertion_node);
+                occupied_.set(index);
+                occupied_.set(last);
+                _instrumentation().insert(displacement);
+                return probe_length;
+            }
+
+            size_type _insertion_helper(node &&insertion_node) {
+                size_type index = _hash_to_index(insertion_node.hash());
+                return _insertion_helper(std::move(insertion_node), index);
+            }
+
+            std::pair<iterator, bool> _insert(const value_type &value) {
+                const key_type &key = traits_.select_key(value);
+                return _insert(key, value);
+            }
+
+            std::pair<iterator, bool> _insert(value_type &&value) {
+                const key_type &key = traits_.select_key(value);
+                return _insert(key, reinterpret_cast<mutable_value_type &&>(std::move(value)));
+            }
+
+            template<typename PKey, typename PValue>
+            std::pair<size_type, bool> _insert_hashed(size_t hash, PKey &&key, PValue &&value,
+                                                      size_type &probe_length) {
+                auto insertion_spot_info = _find_spot(std::forward<PKey>(key), hash);
+
+                if (insertion_spot_info.second) {
+                    return std::make_pair(insertion_spot_info.first, false);
+                }
+
+                size_type index = _insert_vacant(hash, insertion_spot_info.first, key, std::forward<PValue>(value),
+                                                 probe_length);
+                return std::make_pair(index, true);
+            }
+
+            template<typename PValue>
+            size_type _insert_vacant(size_t hash, size_type index, const key_type &key, PValue &&value,
+                                     size_type &probe_length) {
+                if (_try_to_rehash()) {
+                    index = _find_spot(key, hash).first;
+                }
+
+                node insertion_node = _make_node(hash, std::forward<PValue>(value));
+                probe_length = _insertion_helper(std::move(insertion_node), index);
+                size_++;
+                return index;
+            }
+
+            size_type _find_insertion_slot(size_t hash) const {
+                size_type index = _hash_to_index(hash);
+                size_type distance = 0;
+
+                while (!data_[index].empty() && _distance_to_ideal_bucket(index) >= distance) {
+                    index = _next_index(index);
+                    distance++;
+                }
+                return index;
+            }
+
+            // The caller guarantees the key is not in the table yet, so the probe only compares distances.
+            template<typename PValue>
+            iterator _insert_unique(PValue &&value) {
+                const key_type &key = traits_.select_key(value);
+                size_t hash = traits_(key);
+                assert(!_find_spot(key, hash).second && "insert_unique_unchecked: the key is already in the table");
+
+                _try_to_rehash();
+                size_type index = _find_insertion_slot(hash);
+                node insertion_node = _make_node(hash, std::forward<PValue>(value));
+                size_type probe_length = _insertion_helper(std::move(insertion_node), index);
+                size_++;
+                return _iterator_at(_try_to_reseed(probe_length, index));
+            }
+
+            template<typename PValue>
+            iterator _insert_hint(const_iterator hint, PValue &&value) {
+                const key_type &key = traits_.select_key(value);
+                if (hint != cend() && traits_(traits_.select_key(*hint), key)) {
+                    return mutable_iterator(hint);
+                }
+                return _insert(key, std::forward<PValue>(value)).first;
+            }
+
+            template<typename PKey, typename PValue>
+            std::pair<iterator, bool> _insert(PKey &&key, PValue &&value) {
+                size_t hash = traits_(std::forward<PKey>(key));
+                size_type probe_length = 0;
+
+                auto insertion_info = _insert_hashed(hash, std::forward<PKey>(key), std::forward<PValue>(value),
+                                                     probe_length);
+                if (insertion_info.second) {
+                    insertion_info.first = _try_to_reseed(probe_length, insertion_info.first);
+                }
+                return std::make_pair(_iterator_at(insertion_info.first), insertion_info.second);
+            }
+
+        public:
+            hash_table() = default;
+
+            explicit hash_table(size_type capacity,
+                                const hasher &key_hash_function = hasher{},
+                                const key_equal &key_equal_function = key_equal{},
+                                const allocator_type &allocator = allocator_type{})
+                    : traits_(key_compare(key_hash_function, key_equal_function)),
+                      data_(capacity, allocator),
+                      pool_(allocator),
+                      occupied_(capacity, allocator) {
+            }
+
+            explicit hash_table(size_type capacity,
+                                const traits_type &traits,
+                                const allocator_type &allocator = allocator_type{})
+                    : traits_(traits),
+                      data_(capacity, allocator),
+                      pool_(allocator),
+                      occupied_(capacity, allocator) {}
+
+            template<typename InputIt>
+            hash_table(InputIt begin, InputIt end,
+                       size_type capacity = 0,
+                       const hasher &key_hash_function = hasher{},
+                       const key_equal &key_equal_function = key_equal{},
+                       const allocator_type &allocator = allocator_type{})
+                    : traits_(key_compare(key_hash_function, key_equal_function)),
+                      data_(capacity, allocator),
+                      pool_(allocator),
+                      occupied_(capacity, allocator) {
+                insert(begin, end);
+            }
+
+            hash_table(std::initializer_list<value_type> list,
+                       size_type capacity = 0,
+                       const hasher &key_hash_function = hasher{},
+                       const key_equal &key_equal_function = key_equal{},
+                       const allocator_type &allocator = allocator_type{})
+                    : traits_(key_compare(key_hash_function, key_equal_function)),
+                      data_(capacity, allocator),
+                      pool_(allocator),
+                      occupied_(capacity, allocator) {
+                insert(list);
+            }
+
+            hash_table(const hash_table &other)
+                    : instrumentation_base(other),
+                      traits_(other.traits_),
+                      load_factor_(other.load_factor_),
+                      size_(other.size_),
+                      data_(other.data_),
+                      pool_(other.get_allocator()),
+                      occupied_(other.occupied_),
+                      rehash_observer_(other.rehash_observer_) {
+                _clone_values();
+            }
+
+            hash_table(const hash_table &other, const allocator_type &allocator)
+                    : instrumentation_base(other),
+                      traits_(other.traits_),
+                      load_factor_(other.load_factor_),
+                      size_(other.size_),
+                      data_(other.data_, allocator),
+                      pool_(allocator),
+                      occupied_(other.occupied_),
+                      rehash_observer_(other.rehash_observer_) {
+                _clone_values();
+            }
+
+            hash_table(hash_table &&other) noexcept(
+            std::is_nothrow_move_constructible<traits_type>::value &&
+            std::is_nothrow_move_constructible<array>::value)
+                    : instrumentation_base(std::move(other)),
+                      traits_((std::move(other.traits_))),
+                      load_factor_(other.load_factor_),
+                      size_(other.size_),
+                      data_(std::move(other.data_)),
+                      pool_(std::move(other.pool_)),
+                      occupied_(std::move(other.occupied_)),
+                      rehash_observer_(std::move(other.rehash_observer_)) {
+                other.clear();
+            }
+
+            hash_table(hash_table &&other, const allocator_type &allocator)
+                    : instrumentation_base(std::move(other)),
+                      traits_((std::move(other.traits_))),
+                      load_factor_(other.load_factor_),
+                      size_(other.size_),
+                      data_(std::move(other.data_), allocator),
+                      pool_(std::move(other.pool_)),
+                      occupied_(std::move(other.occupied_)),
+                      rehash_observer_(std::move(other.rehash_observer_)) {
+                other.clear();
+            }
+
+            ~hash_table() {
+                _destroy_values();
+            }
+
+            hash_table &operator=(const hash_table &other) {
+                if (this == &other) {
+                    return *this;
+                }
+                _destroy_values();
+                data_ = other.data_;
+                pool_.clear();
+                occupied_ = other.occupied_;
+                size_ = other.size_;
+                load_factor_ = other.load_factor_;
+                traits_ = other.traits_;
+                _instrumentation() = other._instrumentation();
+                rehash_observer_ = other.rehash_observer_;
+                _clone_values();
+                return *this;
+            }
+
+            hash_table &operator=(hash_table &&other) noexcept {
+                if (this == &other) {
+                    return *this;
+                }
+                _destroy_values();
+                data_ = std::move(other.data_);
+                pool_ = std::move(other.pool_);
+                occupied_ = std::move(other.occupied_);
+                size_ = other.size_;
+                load_factor_ = other.load_factor_;
+                traits_ = std::move(other.traits_);
+                _instrumentation() = std::move(other._instrumentation());
+                rehash_observer_ = std::move(other.rehash_observer_);
+                other.clear();
+                return *this;
+            }
+
+            hash_table &operator=(std::initializer_list<value_type> list) noexcept {
+                clear();
+                insert(list);
+                return *this;
+            }
+
+            allocator_type get_allocator() const {
+                return data_.get_allocator();
+            }
+
+            std::pair<iterator, bool> insert(const value_type &value) {
+                return _insert(value);
+            }
+
+            std::pair<iterator, bool> insert(value_type &&value) {
+                return _insert(std::move(value));
+            }
+
+            iterator insert(const_iterator hint, const value_type &value) {
+                return _insert_hint(hint, value);
+            }
+
+            iterator insert(const_iterator hint, value_type &&value) {
+                return _insert_hint(hint, reinterpret_cast<mutable_value_type &&>(std::move(value)));
+            }
+
+            template<typename InputIt>
+            void insert(InputIt begin, InputIt end) {
+                for (; begin != end; ++begin) {
+                    _insert(value_type(*begin));
+                }
+            }
+
+            void insert(std::initializer_list<value_type> list) {
+                insert(list.begin(), list.end());
+            }
+
+            iterator insert_unique_unchecked(const value_type &value) {
+                return _insert_unique(value);
+            }
+
+            iterator insert_unique_unchecked(value_type &&value) {
+                return _insert_unique(reinterpret_cast<mutable_value_type &&>(std::move(value)));
+            }
+
+            template<typename InputIt>
+            void bulk_load_unique(InputIt begin, InputIt end) {
+                using category = typename std::iterator_traits<InputIt>::iterator_category;
+                if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+                    auto count = static_cast<size_type>(std::distance(begin, end));
+                    reserve(static_cast<size_type>(static_cast<float>(size_ + count) / load_factor_));
+                }
+                for (; begin != end; ++begin) {
+                    _insert_unique(*begin);
+                }
+            }
+
+            template<typename ...Args>
+            std::pair<iterator, bool> emplace(Args ...args) {
+                return _insert(value_type(std::forward<Args>(args)...));
+            }
+
+            template<typename ...Args>
+            iterator emplace_hint(const_iterator hint, Args ...args) {
+                return _insert_hint(hint, mutable_value_type(std::forward<Args>(args)...));
+            }
+
+            // Probes with the given key and converts it to key_type only when a new element is created.
+            template<typename PKey, typename ...Args>
+            std::pair<iterator, bool> try_emplace(PKey &&key, Args &&...args) {
+                if constexpr (_is_lookup_key<PKey>()) {
+                    size_t hash = traits_(key);
+                    auto spot_info = _find_spot(key, hash);
+                    if (spot_info.second) {
+                        return std::make_pair(_iterator_at(spot_info.first), false);
+                    }
+
+                    mutable_value_type value = traits_.make_value(std::forward<PKey>(key), std::forward<Args>(args)...);
+                    size_type probe_length = 0;
+                    size_type index = _insert_vacant(hash, spot_info.first, traits_.select_key(value), std::move(value),
+                                                     probe_length);
+                    return std::make_pair(_iterator_at(_try_to_reseed(probe_length, index)), true);
+                } else {
+                    return try_emplace(key_type(std::forward<PKey>(key)), std::forward<Args>(args)...);
+                }
+            }
+
+            entry find_entry(key_type key) {
+                size_t hash = traits_(key);
+                auto spot_info = _find_spot(key, hash);
+                return entry(this, std::move(key), hash, spot_info.first, spot_info.second);
+            }
+
+            // Returns the element that follows the erased one. A backward shift that wraps around pulls an element
+            // from the front of the array into the last slot, so a begin() to end() loop erasing through this can
+            // visit that element twice; make_cursor() walks the table in an order where that can't happen.
+            iterator erase(iterator position) {
+                if (position == end()) {
+                    return end();
+                }
+                size_type index = position.data_ - data_.data();
+                _erase_at(index);
+                // The last slot can only be refilled from the front of the array, which was already visited
+                if (index + 1 == data_.size()) {
+                    return end();
+                }
+                if (position.data_->empty()) {
+                    ++position;
+                }
+                return position;
+            }
+
+            iterator erase(const_iterator position) {
+                return erase(mutable_iterator(position));
+            }
+
+            // Erases by position up to the slot of last. That slot moves down whenever a shift passes over it, and
+            // an end() bound moves down whenever a shift wraps, so elements from outside the range are never erased.
+            iterator erase(const_iterator first, const_iterator last) {
+                if (first == last) {
+                    return mutable_iterator(last);
+                }
+                size_type index = first.data_ - data_.data();
+                size_type stop = last == cend() ? data_.size() : last.data_ - data_.data();
+                while (index < stop) {
+                    if (data_[index].empty()) {
+                        ++index;
+                        continue;
+                    }
+                    size_type unmoved = _erase_at(index);
+                    size_type shifted_end = unmoved > index ? unmoved : unmoved + data_.size();
+                    if (stop < shifted_end) {
+                        --stop;
+                    }
+                }
+                return last == cend() ? end() : _iterator_at(stop);
+            }
+
+            // A cursor over all elements that may erase the current one.
+            cursor make_cursor() {
+                return cursor(this);
+            }
+
+            size_type erase(const key_type &key) {
+                return _erase(key);
+            }
+
+            // Hashes every key first, then erases them in input order while prefetching the home slot a few keys
+            // ahead. Each key is still probed on its own, so the shifts of earlier erases can't make a later one miss.
+            // Keys are borrowed from the range when it yields key_type lvalues and converted into the batch otherwise.
+            template<typename ForwardIt>
+            size_type erase_batch(ForwardIt begin, ForwardIt end) {
+                static constexpr const size_type kPrefetchDistance = 8;
+                static constexpr const bool kBorrowed = std::is_lvalue_reference_v<
+                        typename std::iterator_traits<ForwardIt>::reference> && std::is_same_v<
+                        std::decay_t<typename std::iterator_traits<ForwardIt>::reference>, key_type>;
+
+                if (size_ == 0) {
+                    return 0;
+                }
+                struct hashed_key {
+                    size_type home;
+                    size_t hash;
+                    std::conditional_t<kBorrowed, const key_type *, key_type> key;
+
+                    const key_type &get() const {
+                        if constexpr (kBorrowed) {
+                            return *key;
+                        } else {
+                            return key;
+                        }
+                    }
+                };
+                std::vector<hashed_key> batch;
+                batch.reserve(static_cast<size_type>(std::distance(begin, end)));
+                for (; begin != end; ++begin) {
+                    if constexpr (kBorrowed) {
+                        const key_type &key = *begin;
+                        size_t hash = traits_(key);
+                        batch.push_back(hashed_key{_hash_to_index(hash), hash, &key});
+                    } else {
+                        key_type key(*begin);
+                        size_t hash = traits_(key);
+                        batch.push_back(hashed_key{_hash_to_index(hash), hash, std::move(key)});
+                    }
+                }
+
+                size_type old_size = size_;
+                for (size_type i = 0; i < batch.size(); ++i) {
+                    if (i + kPrefetchDistance < batch.size()) {
+                        detail::prefetch(&data_[batch[i + kPrefetchDistance].home]);
+                    }
+                    _erase(batch[i].get(), batch[i].hash);
+                }
+                return old_size - size_;
+            }
+
+            // Walks the array once starting after an empty slot, so backward shifts only ever pull in elements that
+            // have not been visited yet.
+            template<typename Predicate>
+            size_type erase_if(Predicate predicate) {
+                if (size_ == 0) {
+                    return 0;
+                }
+                size_type old_size = size_;
+                size_type start = _first_empty();
+                size_type index = _next_index(start);
+                while (index != start) {
+                    if (!data_[index].empty() && predicate(reinterpret_cast<reference>(data_[index].value()))) {
+                        _erase_at(index);
+                    } else {
+                        index = _next_index(index);
+                    }
+                }
+                return old_size - size_;
+            }
+
+            size_type count(const key_type &key) const {
+                auto spot_info = _find_spot(key);
+                if (spot_info.second) {
+                    return 1;
+                } else {
+                    return 0;
+                }
+            }
+
+            template<typename PKey>
+            size_type count(const PKey &key) const {
+                return _find_lookup_spot(key).second ? 1 : 0;
+            }
+
+            iterator find(const key_type &key) {
+                return mutable_iterator(static_cast<const hash_table *>(this)->find(key));
+            }
+
+            const_iterator find(const key_type &key) const {
+                auto spot_info = _find_spot(key);
+
+                if (!spot_info.second) {
+                    return end();
+                }
+                return _const_iterator_at(spot_info.first);
+            }
+
+            template<typename PKey>
+            iterator find(const PKey &key) {
+                return mutable_iterator(static_cast<const hash_table *>(this)->find(key));
+            }
+
+            template<typename PKey>
+            const_iterator find(const PKey &key) const {
+                auto spot_info = _find_lookup_spot(key);
+
+                if (!spot_info.second) {
+                    return end();
+                }
+                return _const_iterator_at(spot_info.first);
+            }
+
+            bool contains(const key_type &key) const {
+                return count(key) == 1;
+            }
+
+            template<typename PKey>
+            bool contains(const PKey &key) const {
+                return count(key) == 1;
+            }
+
+            std::pair<iterator, iterator> equal_range(const key_type &key) {
+                iterator founded = find(key);
+                return std::make_pair(founded, std::next(founded));
+            }
+
+            std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+                const_iterator founded = find(key);
+                return std::make_pair(founded, std::next(founded));
+            }
+
+            //TODO: Two more methods of equal_range
+
+            size_type bucket_count() const {
+                return data_.size();
+            }
+
+            size_type max_bucket_count() const {
+                return std::allocator_traits<node_allocator>::max_size(data_.get_allocator());
+            }
+
+            instrumentation_type &instrumentation() {
+                return _instrumentation();
+            }
+
+            const instrumentation_type &instrumentation() const {
+                return _instrumentation();
+            }
+
+            void set_rehash_observer(rehash_observer observer) {
+                rehash_observer_ = std::move(observer);
+            }
+
+            stats_type stats() const {
+                stats_type result;
+                result.size = size_;
+                result.bucket_count = data_.size();
+                if (data_.empty()) {
+                    return result;
+                }
+
+                size_type total_displacement = 0;
+                size_type first_cluster = 0;
+                size_type current_cluster = 0;
+                for (size_type index = 0; index < data_.size(); ++index) {
+                    if (data_[index].empty()) {
+                        if (current_cluster == index) {
+                            first_cluster = current_cluster;
+                        }
+                        result.longest_cluster = std::max(result.longest_cluster, current_cluster);
+                        current_cluster = 0;
+                        continue;
+                    }
+                    size_type displacement = _distance_to_ideal_bucket(index);
+                    if (result.probe_histogram.size() <= displacement) {
+                        result.probe_histogram.resize(displacement + 1);
+                    }
+                    result.probe_histogram[displacement]++;
+                    total_displacement += displacement;
+                    result.max_displacement = std::max(result.max_displacement, displacement);
+                    current_cluster++;
+                }
+                if (current_cluster == data_.size()) {
+                    result.longest_cluster = current_cluster;
+                } else {
+                    result.longest_cluster = std::max(result.longest_cluster, current_cluster + first_cluster);
+                }
+
+                result.empty_fraction = static_cast<double>(data_.size() - size_) / static_cast<double>(data_.size());
+                if (size_ != 0) {
+                    result.mean_displacement = static_cast<double>(total_displacement) / static_cast<double>(size_);
+                    result.bytes_per_element = static_cast<double>(data_.allocated_bytes() +
+                                                                   occupied_.allocated_bytes() +
+                                                                   pool_.allocated_bytes()) /
+                                               static_cast<double>(size_);
+                }
+                return result;
+            }
+
+            float load_factor() const {
+                return static_cast<float>(size_) / static_cast<float>(data_.size());
+            }
+
+            float max_load_factor() const {
+                return load_factor_;
+            }
+
+            void max_load_factor(float load_factor) {
+                load_factor_ = std::clamp(load_factor, kMinLoadFactor, kMaxLoadFactor);
+                if (!data_.empty() && size_ >= _size_to_rehash()) {
+                    _rehash(_next_capacity(static_cast<size_type>(size_ / load_factor_)));
+                }
+            }
+
+            void rehash(size_type new_capacity) {
+                reserve(new_capacity);
+            }
+
+            void reserve(size_type new_capacity) {
+                size_type next_capacity = _next_capacity(new_capacity);
+
+                if (new_capacity > data_.size()) {
+                    _rehash(next_capacity);
+                }
+            }
+
+            hasher hash_function() const {
+                return traits_.hash_function();
+            }
+
+            key_equal key_eq() const {
+                return traits_.key_eq();
+            }
+
+            bool operator==(const hash_table &other) const {
+                if (other.size() != size()) {
+                    return false;
+                }
+                for (auto it = other.begin(); it != other.end(); ++it) {
+                    if (!contains(other.traits_.select_key(*it))) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool operator!=(const hash_table &other) const {
+                return !this->operator==(other);
+            }
+
+            void clear() {
+                _destroy_values();
+                data_.clear();
+                pool_.clear();
+                occupied_.clear();
+                size_ = 0;
+            }
+
+            void swap(hash_table &other) {
+                std::swap(traits_, other.traits_);
+                std::swap(load_factor_, other.load_factor_);
+                std::swap(size_, other.size_);
+                std::swap(data_, other.data_);
+                std::swap(pool_, other.pool_);
+                std::swap(occupied_, other.occupied_);
+                std::swap(_instrumentation(), other._instrumentation());
+                std::swap(rehash_observer_, other.rehash_observer_);
+            }
+
+            bool empty() const {
+                return size_ == 0;
+            }
+
+            size_type size() const {
+                return size_;
+            }
+
+            iterator mutable_iterator(const_iterator position) {
+                return _iterator_at(position.data_ - data_.data());
+            }
+
+            iterator begin() noexcept {
+                return _iterator_at(_first_occupied(0));
+            }
+
+            iterator end() noexcept {
+                return _iterator_at(data_.size());
+            }
+
+            const_iterator begin() const noexcept {
+                return cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return cend();
+            }
+
+            const_iterator cbegin() const noexcept {
+                return _const_iterator_at(_first_occupied(0));
+            }
+
+            const_iterator cend() const noexcept {
+                return _const_iterator_at(data_.size());
+            }
+
+            iterator rbegin() noexcept {
+                return _iterator_at(occupied_.find_prior(data_.size()));
+            }
+
+            iterator rend() noexcept {
+                return _iterator_at(-1);
+            }
+
+            const_iterator rbegin() const noexcept {
+                return _const_iterator_at(occupied_.find_prior(data_.size()));
+            }
+
+            const_iterator rend() const noexcept {
+                return _const_iterator_at(-1);
+            }
+
+            template<typename Function>
+            void for_each_occupied(Function function) {
+                occupied_.for_each_set([this, &function](size_type index) {
+                    function(reinterpret_cast<reference>(data_[index].value()));
+                });
+            }
+
+            template<typename Function>
+            void for_each_occupied(Function function) const {
+                occupied_.for_each_set([this, &function](size_type index) {
+                    function(reinterpret_cast<const_reference>(data_[index].value()));
+                });
+            }
+
+            std::vector<range> split(size_type count) {
+                auto bounds = _split_bounds(count);
+
+                std::vector<range> ranges;
+                ranges.reserve(bounds.size() - 1);
+                for (size_type i = 1; i < bounds.size(); ++i) {
+                    ranges.emplace_back(_iterator_at(bounds[i - 1]), _iterator_at(bounds[i]));
+                }
+                return ranges;
+            }
+
+            std::vector<const_range> split(size_type count) const {
+                auto bounds = _split_bounds(count);
+
+                std::vector<const_range> ranges;
+                ranges.reserve(bounds.size() - 1);
+                for (size_type i = 1; i < bounds.size(); ++i) {
+                    ranges.emplace_back(_const_iterator_at(bounds[i - 1]), _const_iterator_at(bounds[i]));
+                }
+                return ranges;
+            }
+
+            template<typename ExecutionPolicy, typename Function>
+            void for_each(ExecutionPolicy &&policy, Function function) {
+                auto ranges = split(_default_split_count());
+                std::for_each(std::forward<ExecutionPolicy>(policy), ranges.begin(), ranges.end(),
+                              [&function](const range &part) {
+                                  for (auto &value: part) {
+                                      function(value);
+                                  }
+                              });
+            }
+
+            template<typename ExecutionPolicy, typename Function>
+            void for_each(ExecutionPolicy &&policy, Function function) const {
+                auto ranges = split(_default_split_count());
+                std::for_each(std::forward<ExecutionPolicy>(policy), ranges.begin(), ranges.end(),
+                              [&function](const const_range &part) {
+                                  for (auto &value: part) {
+                                      function(value);
+                                  }
+                              });
+            }
+
+        private:
+            template<typename TItem>
+            class hash_table_iterator {
+                friend class hash_table;
+
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = TItem;
+                using difference_type = std::ptrdiff_t;
+                using reference = value_type &;
+                using pointer = value_type *;
+
+            private:
+                using node_pointer = typename std::conditional<std::is_const<TItem>::value, const node *, node *>::type;
+
+            private:
+                node_pointer data_;
+
+                explicit hash_table_iterator(node_pointer data)
+                        : data_(data) {}
+
+            public:
+                hash_table_iterator()
+                        : data_(nullptr) {}
+
+                hash_table_iterator(const hash_table_iterator &other)
+                        : data_(other.data_) {}
+
+
+                hash_table_iterator &operator=(const hash_table_iterator &other) {
+                    data_ = other.data_;
+                    return *this;
+                }
+
+            public:
+                reference operator*() const {
+                    return reinterpret_cast<reference>(data_->value());
+                }
+
+                pointer operator->() const {
+                    return reinterpret_cast<pointer>(&data_->value());
+                }
+
+                bool operator==(const hash_table_iterator &other) const {
+                    return data_ == other.data_;
+                }
+
+                bool operator!=(const hash_table_iterator &other) const {
+                    return data_ != other.data_;
+                }
+
+                hash_table_iterator &operator++() {
+                    go_next();
+                    return *this;
+                }
+
+                hash_table_iterator operator++(int) {
+                    hash_table_iterator result = *this;
+                    go_next();
+                    return result;
+                }
+
+                hash_table_iterator &operator--() {
+                    go_prior();
+                    return *this;
+                }
+
+                hash_table_iterator operator--(int) {
+                    hash_table_iterator result = *this;
+                    go_prior();
+                    return result;
+                }
+
+            private:
+                // A single node pointer can't reach the occupancy bitmap, so ++ and -- test one node at a time. On a
+                // sparse table that reads every empty node; for_each_occupied() and split() still skip through the
+                // bitmap a word at a time.
+                void go_next() {
+                    do {
+                        ++data_;
+                    } while (data_->empty());
+                }
+
+                void go_prior() {
+                    do {
+                        --data_;
+                    } while (data_->empty());
+                }
+            };
+
+            // Result of a single probe for a key. It stays valid until the table is modified through anything
+            // other than the entry itself.
+            class hash_table_entry {
+                friend class hash_table;
+
+            private:
+                hash_table *table_;
+                key_type key_;
+                size_t hash_;
+                size_type index_;
+                bool occupied_;
+                // key_ was moved into the table by emplace
+                bool key_moved_;
+                // index_ was left stale by erase and is found again by the next emplace
+                bool needs_probe_;
+
+                hash_table_entry(hash_table *table, key_type &&key, size_t hash, size_type index, bool occupied)
+                        : table_(table),
+                          key_(std::move(key)),
+                          hash_(hash),
+                          index_(index),
+                          occupied_(occupied),
+                          key_moved_(false),
+                          needs_probe_(false) {}
+
+            public:
+                bool occupied() const {
+                    return occupied_;
+                }
+
+                explicit operator bool() const {
+                    return occupied_;
+                }
+
+                const key_type &key() const {
+                    return occupied_ ? table_->traits_.select_key(table_->data_[index_].value()) : key_;
+                }
+
+                iterator position() const {
+                    return occupied_ ? table_->_iterator_at(index_) : table_->end();
+                }
+
+                reference operator*() const {
+                    assert(occupied_);
+                    return reinterpret_cast<reference>(table_->data_[index_].value());
+                }
+
+                pointer operator->() const {
+                    return &**this;
+                }
+
+                // Returns the existing element without touching args if the entry is occupied.
+                template<typename ...Args>
+                reference emplace(Args &&...args) {
+                    if (needs_probe_) {
+                        auto spot_info = table_->_find_spot(key_, hash_);
+                        index_ = spot_info.first;
+                        occupied_ = spot_info.second;
+                        needs_probe_ = false;
+                    }
+                    if (occupied_) {
+                        return **this;
+                    }
+                    size_type probe_length = 0;
+                    mutable_value_type value = table_->traits_.make_value(std::move(key_), std::forward<Args>(args)...);
+                    index_ = table_->_insert_vacant(hash_, index_, table_->traits_.select_key(value), std::move(value),
+                                                    probe_length);
+                    index_ = table_->_try_to_reseed(probe_length, index_);
+                    occupied_ = true;
+                    key_moved_ = true;
+                    return **this;
+                }
+
+                template<typename ...Args>
+                reference or_emplace(Args &&...args) {
+                    return occupied_ ? **this : emplace(std::forward<Args>(args)...);
+                }
+
+                void erase() {
+                    assert(occupied_);
+                    if (key_moved_) {
+                        key_ = key();
+                        key_moved_ = false;
+                    }
+                    table_->_erase_at(index_);
+                    occupied_ = false;
+                    needs_probe_ = true;
+                }
+            };
+
+            // Walks the array once starting after an empty slot, like erase_if, so the backward shift of an erase only
+            // ever pulls in elements that have not been visited yet.
+            class hash_table_cursor {
+                friend class hash_table;
+
+            private:
+                hash_table *table_;
+                size_type start_;
+                size_type index_;
+
+                explicit hash_table_cursor(hash_table *table)
+                        : table_(table),
+                          start_(0),
+                          index_(0) {
+                    if (table_->size_ != 0) {
+                        start_ = table_->_first_empty();
+                        index_ = table_->_next_index(start_);
+                        skip_empty();
+                    }
+                }
+
+                void skip_empty() {
+                    while (index_ != start_ && table_->data_[index_].empty()) {
+                        index_ = table_->_next_index(index_);
+                    }
+                }
+
+            public:
+                explicit operator bool() const {
+                    return index_ != start_;
+                }
+
+                reference operator*() const {
+                    return reinterpret_cast<reference>(table_->data_[index_].value());
+                }
+
+                pointer operator->() const {
+                    return &**this;
+                }
+
+                void next() {
+                    index_ = table_->_next_index(index_);
+                    skip_empty();
+                }
+
+                // Erases the current element and moves on to the next one.
+                void erase() {
+                    table_->_erase_at(index_);
+                    skip_empty();
+                }
+            };
+
+            template<typename TIterator>
+            class hash_table_range {
+                friend class hash_table;
+
+            public:
+                using iterator = TIterator;
+
+            private:
+                iterator begin_;
+                iterator end_;
+
+            public:
+                hash_table_range(iterator begin, iterator end)
+                        : begin_(begin),
+                          end_(end) {}
+
+                iterator begin() const {
+                    return begin_;
+                }
+
+                iterator end() const {
+                    return end_;
+                }
+
+                bool empty() const {
+                    return begin_ == end_;
+                }
+            };
+        };
+
+        template<class Traits, class Instrumentation>
+        class segmented_hash_table {
+            template<typename TSegment, typename TIterator>
+            class segmented_iterator;
+
+            using segment = hash_table<Traits, Instrumentation>;
+            using traits_type = Traits;
+            using segment_pointer = std::unique_ptr<segment>;
+
+            static_assert(!Traits::storage_policy::kStableValues,
+                          "splitting moves nodes between segments, each of which owns its own value pool");
+
+            static constexpr const size_t kDefaultSegmentCapacity = 1u << 14u;
+            static constexpr const size_t kMaxDepth = 24;
+            static constexpr const uint64_t kMixMultiplier = 0x9e3779b97f4a7c15ull;
+
+        public:
+            using value_type = typename segment::value_type;
+            using mutable_value_type = typename segment::mutable_value_type;
+            using key_type = typename segment::key_type;
+            using hasher = typename segment::hasher;
+            using key_equal = typename segment::key_equal;
+            using allocator_type = typename segment::allocator_type;
+            using size_type = typename segment::size_type;
+            using difference_type = typename segment::difference_type;
+            using reference = typename segment::reference;
+            using const_reference = typename segment::const_reference;
+            using pointer = typename segment::pointer;
+            using const_pointer = typename segment::const_pointer;
+
+            using iterator = segmented_iterator<segment, typename segment::iterator>;
+            using const_iterator = segmented_iterator<const segment, typename segment::const_iterator>;
+
+        private:
+            traits_type traits_;
+            allocator_type allocator_;
+            size_type segment_capacity_{kDefaultSegmentCapacity};
+            float load_factor_{segment::kDefaultLoadFactor};
+            size_type global_depth_{0};
+            std::vector<segment_pointer> segments_;
+            std::vector<size_type> depths_;
+            std::vector<size_type> directory_;
+
+        private:
+            static uint64_t _mix(size_t hash) {
+                return static_cast<uint64_t>(hash) * kMixMultiplier;
+            }
+
+            size_type _directory_index(size_t hash) const {
+                return global_depth_ == 0 ? 0 : static_cast<size_type>(_mix(hash) >> (64u - global_depth_));
+            }
+
+            segment &_segment_for(size_t hash) const {
+                return *segments_[directory_[_directory_index(hash)]];
+            }
+            segment_pointer _make_segment(size_type capacity) const {
+                auto result = std::make_unique<segment>(capacity, traits_, allocator_);
+                result->load_factor_ = load_factor_;
+                return result;
+            }
+
+            // An empty table has no segments at all, the first one is allocated by the first insert.
+            void _reset() noexcept {
+                global_depth_ = 0;
+                segments_.clear();
+                depths_.clear();
+                directory_.clear();
+            }
+
+            void _allocate_first_segment() {
+                segments_.push_back(_make_segment(segment_capacity_));
+                depths_.push_back(0);
+                directory_.assign(1, 0);
+            }
+
+            static bool _split_bit(size_t hash, size_type depth) {
+                return (_mix(hash) >> (63u - depth)) & 1u;
+            }
+
+            bool _is_separable(size_type segment_index) const {
+                bool seen[2] = {false, false};
+                for (const auto &item: segments_[segment_index]->data_) {
+                    if (!item.empty()) {
+                        seen[_split_bit(item.hash(), depths_[segment_index])] = true;
+                        if (seen[0] && seen[1]) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            bool _needs_split(size_type directory_index) const {
+                size_type segment_index = directory_[directory_index];
+                const segment &current = *segments_[segment_index];
+                if (depths_[segment_index] >= kMaxDepth || current.size_ + 1 < current._size_to_rehash()) {
+                    return false;
+                }
+                return _is_separable(segment_index);
+            }
+
+            void _double_directory() {
+                std::vector<size_type> directory(directory_.size() * 2);
+                for (size_type i = 0; i < directory_.size(); ++i) {
+                    directory[2 * i] = directory_[i];
+                    directory[2 * i + 1] = directory_[i];
+                }
+                directory_.swap(directory);
+                global_depth_++;
+            }
+
+            void _split(size_type directory_index) {
+                size_type segment_index = directory_[directory_index];
+                size_type depth = depths_[segment_index];
+                if (depth == global_depth_) {
+                    _double_directory();
+                    directory_index *= 2;
+                }
+
+                // The old segment keeps the low half in place, so a split allocates only the high half.
+                segment &old = *segments_[segment_index];
+                segment_pointer high = _make_segment(old.data_.size());
+                old._extract_if([depth](const auto &item) { return _split_bit(item.hash(), depth); },
+                                [&high](auto &&item) {
+                                    high->_insertion_helper(std::move(item));
+                                    high->size_++;
+                                });
+
+                size_type span = size_type(1) << (global_depth_ - depth);
+                size_type first = directory_index & ~(span - 1);
+                size_type high_index = segments_.size();
+                segments_.push_back(std::move(high));
+                depths_[segment_index] = depth + 1;
+                depths_.push_back(depth + 1);
+                std::fill(directory_.begin() + first + span / 2, directory_.begin() + first + span, high_index);
+            }
+
+            // Probes for the key first, so a key that is already present neither splits a segment nor calls make_value.
+            template<typename MakeValue>
+            std::pair<iterator, bool> _insert(const key_type &key, size_t hash, MakeValue make_value) {
+                if (segments_.empty()) {
+                    _allocate_first_segment();
+                }
+                size_type directory_index = _directory_index(hash);
+                size_type segment_index = directory_[directory_index];
+                auto spot_info = segments_[segment_index]->_find_spot(key, hash);
+                if (spot_info.second) {
+                    return std::make_pair(iterator(&segments_, segment_index,
+                                                   segments_[segment_index]->_iterator_at(spot_info.first)), false);
+                }
+                if (_needs_split(directory_index)) {
+                    do {
+                        _split(directory_index);
+                        directory_index = _directory_index(hash);
+                    } while (_needs_split(directory_index));
+                    segment_index = directory_[directory_index];
+                    spot_info = segments_[segment_index]->_find_spot(key, hash);
+                }
+
+                segment &target = *segments_[segment_index];
+                auto &&value = make_value();
+                size_type probe_length = 0;
+                size_type index = target._insert_vacant(hash, spot_info.first, target.traits_.select_key(value),
+                                                        std::forward<decltype(value)>(value), probe_length);
+                return std::make_pair(iterator(&segments_, segment_index, target._iterator_at(index)), true);
+            }
+
+        public:
+            segmented_hash_table() = default;
+
+            explicit segmented_hash_table(size_type segment_capacity,
+                                          const hasher &key_hash_function = hasher{},
+                                          const key_equal &key_equal_function = key_equal{},
+                                          const allocator_type &allocator = allocator_type{})
+                    : traits_(typename traits_type::key_compare(key_hash_function, key_equal_function)),
+                      allocator_(allocator),
+                      segment_capacity_(std::max(segment_capacity, size_type(8))) {}
+
+            segmented_hash_table(const segmented_hash_table &other)
+                    : traits_(other.traits_),
+                      allocator_(other.allocator_),
+                      segment_capacity_(other.segment_capacity_),
+                      load_factor_(other.load_factor_),
+                      global_depth_(other.global_depth_),
+                      depths_(other.depths_),
+                      directory_(other.directory_) {
+                segments_.reserve(other.segments_.size());
+                for (const auto &item: other.segments_) {
+                    segments_.push_back(std::make_unique<segment>(*item));
+                }
+            }
+
+            segmented_hash_table(segmented_hash_table &&other) noexcept
+                    : traits_(std::move(other.traits_)),
+                      allocator_(std::move(other.allocator_)),
+                      segment_capacity_(other.segment_capacity_),
+                      load_factor_(other.load_factor_),
+                      global_depth_(other.global_depth_),
+                      segments_(std::move(other.segments_)),
+                      depths_(std::move(other.depths_)),
+                      directory_(std::move(other.directory_)) {
+                other._reset();
+            }
+
+            segmented_hash_table &operator=(const segmented_hash_table &other) {
+                if (this != &other) {
+                    segmented_hash_table copy(other);
+                    swap(copy);
+                }
+                return *this;
+            }
+
+            segmented_hash_table &operator=(segmented_hash_table &&other) noexcept {
+                if (this != &other) {
+                    swap(other);
+                    other.clear();
+                }
+                return *this;
+            }
+
+            allocator_type get_allocator() const {
+                return allocator_;
+            }
+
+            std::pair<iterator, bool> insert(const value_type &value) {
+                const key_type &key = traits_.select_key(value);
+                return _insert(key, traits_(key), [&value]() -> const value_type & { return value; });
+            }
+
+            std::pair<iterator, bool> insert(value_type &&value) {
+                const key_type &key = traits_.select_key(value);
+                return _insert(key, traits_(key), [&value]() -> mutable_value_type && {
+                    return reinterpret_cast<mutable_value_type &&>(value);
+                });
+            }
+
+            template<typename InputIt>
+            void insert(InputIt begin, InputIt end) {
+                for (; begin != end; ++begin) {
+                    insert(value_type(*begin));
+                }
+            }
+
+            template<typename ...Args>
+            std::pair<iterator, bool> emplace(Args &&...args) {
+                return insert(value_type(std::forward<Args>(args)...));
+            }
+
+            // Builds the value only when the key is not in the table yet.
+            template<typename PKey, typename ...Args>
+            std::pair<iterator, bool> try_emplace(PKey &&key, Args &&...args) {
+                if constexpr (std::is_same_v<std::decay_t<PKey>, key_type>) {
+                    return _insert(key, traits_(key), [&]() {
+                        return traits_.make_value(std::forward<PKey>(key), std::forward<Args>(args)...);
+                    });
+                } else {
+                    return try_emplace(key_type(std::forward<PKey>(key)), std::forward<Args>(args)...);
+                }
+            }
+
+            size_type erase(const key_type &key) {
+                if (segments_.empty()) {
+                    return 0;
+                }
+                size_t hash = traits_(key);
+                return _segment_for(hash)._erase(key, hash);
+            }
+
+            template<typename Predicate>
+            size_type erase_if(Predicate predicate) {
+                size_type erased = 0;
+                for (auto &item: segments_) {
+                    erased += item->erase_if(std::ref(predicate));
+                }
+                return erased;
+            }
+
+            template<typename ForwardIt>
+            size_type erase_batch(ForwardIt begin, ForwardIt end) {
+                size_type erased = 0;
+                for (; begin != end; ++begin) {
+                    erased += erase(*begin);
+                }
+                return erased;
+            }
+
+            iterator find(const key_type &key) {
+                if (segments_.empty()) {
+                    return end();
+                }
+                size_t hash = traits_(key);
+                size_type segment_index = directory_[_directory_index(hash)];
+                auto spot_info = segments_[segment_index]->_find_spot(key, hash);
+                if (!spot_info.second) {
+                    return end();
+                }
+                return iterator(&segments_, segment_index, segments_[segment_index]->_iterator_at(spot_info.first));
+            }
+
+            const_iterator find(const key_type &key) const {
+                if (segments_.empty()) {
+                    return end();
+                }
+                size_t hash = traits_(key);
+                size_type segment_index = directory_[_directory_index(hash)];
+                auto spot_info = segments_[segment_index]->_find_spot(key, hash);
+                if (!spot_info.second) {
+                    return end();
+                }
+                return const_iterator(&segments_, segment_index,
+                                      segments_[segment_index]->_const_iterator_at(spot_info.first));
+            }
+
+            size_type count(const key_type &key) const {
+                if (segments_.empty()) {
+                    return 0;
+                }
+                size_t hash = traits_(key);
+                return _segment_for(hash)._find_spot(key, hash).second ? 1 : 0;
+            }
+
+            bool contains(const key_type &key) const {
+                return count(key) == 1;
+            }
+
+            iterator begin() noexcept {
+                return iterator::first(&segments_);
+            }
+
+            iterator end() noexcept {
+                return iterator::last(&segments_);
+            }
+
+            const_iterator begin() const noexcept {
+                return const_iterator::first(&segments_);
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator::last(&segments_);
+            }
+
+            const_iterator cbegin() const noexcept {
+                return begin();
+            }
+
+            const_iterator cend() const noexcept {
+                return end();
+            }
+
+            size_type size() const noexcept {
+                size_type result = 0;
+                for (const auto &item: segments_) {
+                    result += item->size();
+                }
+                return result;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            size_type bucket_count() const noexcept {
+                size_type result = 0;
+                for (const auto &item: segments_) {
+                    result += item->bucket_count();
+                }
+                return result;
+            }
+
+            size_type segment_count() const noexcept {
+                return segments_.size();
+            }
+
+            size_type segment_capacity() const noexcept {
+                return segment_capacity_;
+            }
+
+            size_type global_depth() const noexcept {
+                return global_depth_;
+            }
+
+            float load_factor() const {
+                if (segments_.empty()) {
+                    return 0;
+                }
+                return static_cast<float>(size()) / static_cast<float>(bucket_count());
+            }
+
+            float max_load_factor() const {
+                return load_factor_;
+            }
+
+            void max_load_factor(float load_factor) {
+                load_factor_ = std::clamp(load_factor, segment::kMinLoadFactor, segment::kMaxLoadFactor);
+                for (auto &item: segments_) {
+                    item->max_load_factor(load_factor_);
+                }
+            }
+
+            hasher hash_function() const {
+                return traits_.hash_function();
+            }
+
+            key_equal key_eq() const {
+                return traits_.key_eq();
+            }
+
+            void clear() {
+                _reset();
+            }
+
+            void swap(segmented_hash_table &other) {
+                std::swap(traits_, other.traits_);
+                std::swap(allocator_, other.allocator_);
+                std::swap(segment_capacity_, other.segment_capacity_);
+                std::swap(load_factor_, other.load_factor_);
+                std::swap(global_depth_, other.global_depth_);
+                segments_.swap(other.segments_);
+                depths_.swap(other.depths_);
+                directory_.swap(other.directory_);
+            }
+
+        private:
+            template<typename TSegment, typename TIterator>
+            class segmented_iterator {
+                friend class segmented_hash_table;
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = typename TIterator::value_type;
+                using difference_type = std::ptrdiff_t;
+                using reference = typename TIterator::reference;
+                using pointer = typename TIterator::pointer;
+
+            private:
+                using segment_list = typename std::conditional<std::is_const<TSegment>::value,
+                        const std::vector<segment_pointer>, std::vector<segment_pointer>>::type;
+
+            private:
+                segment_list *segments_;
+                size_type index_;
+                TIterator current_;
+
+                segmented_iterator(segment_list *segments, size_type index, TIterator current)
+                        : segments_(segments),
+                          index_(index),
+                          current_(current) {}
+
+                static segmented_iterator first(segment_list *segments) {
+                    if (segments->empty()) {
+                        return segmented_iterator(segments, 0, TIterator());
+                    }
+                    segmented_iterator result(segments, 0, static_cast<TSegment &>(*(*segments)[0]).begin());
+                    result.skip_exhausted();
+                    return result;
+                }
+
+                static segmented_iterator last(segment_list *segments) {
+                    if (segments->empty()) {
+                        return segmented_iterator(segments, 0, TIterator());
+                    }
+                    size_type index = segments->size() - 1;
+                    return segmented_iterator(segments, index, static_cast<TSegment &>(*(*segments)[index]).end());
+                }
+
+                void skip_exhausted() {
+                    while (index_ + 1 < segments_->size() &&
+                           current_ == static_cast<TSegment &>(*(*segments_)[index_]).end()) {
+                        ++index_;
+                        current_ = static_cast<TSegment &>(*(*segments_)[index_]).begin();
+                    }
+                }
+
+            public:
+                segmented_iterator()
+                        : segments_(nullptr),
+                          index_(0),
+                          current_() {}
+
+                reference operator*() const {
+                    return *current_;
+                }
+
+                pointer operator->() const {
+                    return current_.operator->();
+                }
+
+                bool operator==(const segmented_iterator &other) const {
+                    return index_ == other.index_ && current_ == other.current_;
+                }
+
+                bool operator!=(const segmented_iterator &other) const {
+                    return !(*this == other);
+                }
+
+                segmented_iterator &operator++() {
+                    ++current_;
+                    skip_exhausted();
+                    return *this;
+                }
+
+                segmented_iterator operator++(int) {
+                    segmented_iterator old = *this;
+                    ++(*this);
+                    return old;
+                }
+            };
+        };
+    }
+
+    class no_instrumentation {
+    public:
+        using size_type = size_t;
+
+    public:
+        void lookup(bool hit, size_type probe_length) const {
+            (void) hit;
+            (void) probe_length;
+        }
+
+        void insert(size_type displacement) const {
+            (void) displacement;
+        }
+
+        void backward_shift(size_type length) const {
+            (void) length;
+        }
+
+        void rehash_begin(size_type old_capacity, size_type new_capacity, size_type size) const {
+            (void) old_capacity;
+            (void) new_capacity;
+            (void) size;
+        }
+
+        void rehash_end(size_type old_capacity, size_type new_capacity, size_type size) const {
+            (void) old_capacity;
+            (void) new_capacity;
+            (void) size;
+        }
+    };
+
+    class counting_instrumentation {
+    public:
+        using size_type = size_t;
+        using clock = std::chrono::steady_clock;
+
+        struct rehash_record {
+            size_type old_capacity{0};
+            size_type new_capacity{0};
+            size_type size{0};
+            clock::duration duration{};
+        };
+
+    private:
+        size_type lookup_hits_{0};
+        size_type lookup_misses_{0};
+        std::vector<size_type> probe_histogram_;
+        size_type inserts_{0};
+        size_type insert_displacement_{0};
+        size_type backward_shifts_{0};
+        size_type backward_shift_length_{0};
+        size_type rehashes_{0};
+        clock::duration rehash_time_{};
+        clock::time_point rehash_start_{};
+        rehash_record last_rehash_;
+
+    public:
+        void lookup(bool hit, size_type probe_length) {
+            if (hit) {
+                lookup_hits_++;
+            } else {
+                lookup_misses_++;
+            }
+            if (probe_histogram_.size() <= probe_length) {
+                probe_histogram_.resize(probe_length + 1);
+            }
+            probe_histogram_[probe_length]++;
+        }
+
+        void insert(size_type displacement) {
+            inserts_++;
+            insert_displacement_ += displacement;
+        }
+
+        void backward_shift(size_type length) {
+            backward_shifts_++;
+            backward_shift_length_ += length;
+        }
+
+        void rehash_begin(size_type old_capacity, size_type new_capacity, size_type size) {
+            (void) old_capacity;
+            (void) new_capacity;
+            (void) size;
+            rehash_start_ = clock::now();
+        }
+
+        void rehash_end(size_type old_capacity, size_type new_capacity, size_type size) {
+            clock::duration duration = clock::now() - rehash_start_;
+            rehashes_++;
+            rehash_time_ += duration;
+            last_rehash_ = rehash_record{old_capacity, new_capacity, size, duration};
+        }
+
+        size_type lookup_hits() const {
+            return lookup_hits_;
+        }
+
+        size_type lookup_misses() const {
+            return lookup_misses_;
+        }
+
+        const std::vector<size_type> &probe_histogram() const {
+            return probe_histogram_;
+        }
+
+        size_type inserts() const {
+            return inserts_;
+        }
+
+        size_type insert_displacement() const {
+            return insert_displacement_;
+        }
+
+        size_type backward_shifts() const {
+            return backward_shifts_;
+        }
+
+        size_type backward_shift_length() const {
+            return backward_shift_length_;
+        }
+
+        size_type rehashes() const {
+            return rehashes_;
+        }
+
+        clock::duration rehash_time() const {
+            return rehash_time_;
+        }
+
+        const rehash_record &last_rehash() const {
+            return last_rehash_;
+        }
+
+        void reset() {
+            *this = counting_instrumentation();
+        }
+    };
+
+#if defined(__linux__)
+
+    template<typename T>
+    class mmap_allocator {
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using propagate_on_container_move_assignment = std::true_type;
+        using is_always_equal = std::true_type;
+
+        mmap_allocator() noexcept = default;
+
+        template<typename U>
+        mmap_allocator(const mmap_allocator<U> &) noexcept {}
+
+        T *allocate(size_type count) {
+            if (count == 0) {
+                return nullptr;
+            }
+            void *pointer = mmap(nullptr, count * sizeof(T), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pointer == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(pointer);
+        }
+
+        void deallocate(T *pointer, size_type count) noexcept {
+            if (pointer != nullptr) {
+                munmap(pointer, count * sizeof(T));
+            }
+        }
+
+        T *reallocate(T *pointer, size_type old_count, size_type new_count) {
+            if (pointer == nullptr) {
+                return allocate(new_count);
+            }
+            void *result = mremap(pointer, old_count * sizeof(T), new_count * sizeof(T), MREMAP_MAYMOVE);
+            if (result == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(result);
+        }
+
+        template<typename U>
+        bool operator==(const mmap_allocator<U> &) const noexcept {
+            return true;
+        }
+
+        template<typename U>
+        bool operator!=(const mmap_allocator<U> &) const noexcept {
+            return false;
+        }
+    };
+
+#endif
+
+    class power_of_two_growth_policy {
+    public:
+        using size_type = size_t;
+
+        static constexpr const bool kModuloIndex = true;
+    public:
+        size_type operator()(size_type current) const {
+            return current * 2;
+        }
+
+        size_type index(size_t hash, size_type capacity) const {
+            return hash % capacity;
+        }
+    };
+
+    class prime_growth_policy {
+    public:
+        using size_type = size_t;
+
+        static constexpr const bool kModuloIndex = true;
+    public:
+        size_type operator()(size_type current) const {
+            for (const auto &item: detail::PRIMES) {
+                if (current < item) {
+                    return item;
+                }
+            }
+            return current;
+        }
+
+        size_type index(size_t hash, size_type capacity) const {
+            return hash % capacity;
+        }
+    };
+
+    template<size_t Numerator = 3, size_t Denominator = 2>
+    class fastrange_growth_policy {
+        static_assert(Numerator > Denominator && Denominator > 0, "growth factor must be greater than one");
+
+        static constexpr const uint64_t kMixMultiplier = 0x9e3779b97f4a7c15ull;
+
+    public:
+        using size_type = size_t;
+    public:
+        size_type operator()(size_type current) const {
+            return current + std::max(size_type(1), current / Denominator * (Numerator - Denominator));
+        }
+
+        size_type index(size_t hash, size_type capacity) const {
+            return detail::multiply_high(detail::multiply_mix(hash, kMixMultiplier), capacity);
+        }
+
+        size_type capacity_for(size_type needed_capacity) const {
+            return needed_capacity + 1;
+        }
+    };
+
+    class flat_storage {
+    public:
+        static constexpr const bool kStableValues = false;
+        static constexpr const bool kKeysInSlots = false;
+        static constexpr const bool kStoresHash = true;
+
+        template<typename TValue, typename TKey>
+        using node_type = detail::robin_hood_node<TValue>;
+
+        template<typename TValue, typename Allocator>
+        using pool_type = detail::no_value_pool;
+    };
+
+    // Slots hold the hash and a pointer into a slab pool owned by the table, so references and pointers to elements
+    // stay valid across rehashing and displacement. Lookups still probe the flat slot array.
+    class stable_storage {
+    public:
+        static constexpr const bool kStableValues = true;
+        static constexpr const bool kKeysInSlots = false;
+        static constexpr const bool kStoresHash = true;
+
+        template<typename TValue, typename TKey>
+        using node_type = detail::stable_node<TValue>;
+
+        template<typename TValue, typename Allocator>
+        using pool_type = detail::value_pool<TValue, Allocator>;
+    };
+
+    // Like stable_storage, but each slot also holds a copy of the key. Probes scan hashes and keys in the slot array
+    // and touch the pooled value only on a hit, which pays off when mapped values are large.
+    class split_storage {
+    public:
+        static constexpr const bool kStableValues = true;
+        static constexpr const bool kKeysInSlots = true;
+        static constexpr const bool kStoresHash = true;
+
+        template<typename TValue, typename TKey>
+        using node_type = detail::keyed_node<TValue, TKey>;
+
+        template<typename TValue, typename Allocator>
+        using pool_type = detail::value_pool<TValue, Allocator>;
+    };
+
+    // Flat slots that don't store the hash and recompute it from the key. KeyHash must be the table's stateless
+    // hasher, e.g. byte_key_hash.
+    template<class KeyHash>
+    class hashless_storage {
+    public:
+        static constexpr const bool kStableValues = false;
+        static constexpr const bool kKeysInSlots = false;
+        static constexpr const bool kStoresHash = false;
+
+        using key_hash = KeyHash;
+
+        template<typename TValue, typename TKey>
+        using node_type = detail::hashless_node<TValue, TKey, KeyHash>;
+
+        template<typename TValue, typename Allocator>
+        using pool_type = detail::no_value_pool;
+    };
+
+    // Hash for fixed-width keys whose bytes are already uniformly distributed, such as UUIDs or digests. The first
+    // eight bytes are the hash.
+    template<class TKey>
+    class byte_key_hash {
+        static_assert(std::is_trivially_copyable_v<TKey> && sizeof(TKey) >= sizeof(size_t),
+                      "byte_key_hash needs a trivially copyable key of at least eight bytes");
+
+    public:
+        size_t operator()(const TKey &key) const noexcept {
+            size_t hash;
+            std::memcpy(&hash, &key, sizeof(hash));
+            return hash;
+        }
+    };
+
+    template<class TKey>
+    class byte_key_equal {
+        static_assert(std::has_unique_object_representations_v<TKey>,
+                      "byte_key_equal compares object representations, padding bytes would break it");
+
+    public:
+        bool operator()(const TKey &first_key, const TKey &second_key) const noexcept {
+            return detail::equal_bytes<sizeof(TKey)>(&first_key, &second_key);
+        }
+    };
+
+    template<class TKey, class KeyHash = std::hash<TKey>>
+    class seeded_hash {
+    public:
+        using key_type = TKey;
+        using hasher = KeyHash;
+        using is_transparent = void;
+
+    private:
+        hasher key_hash_;
+        uint64_t seed_{detail::process_seed()};
+
+    public:
+        seeded_hash() = default;
+
+        explicit seeded_hash(uint64_t seed, const hasher &key_hash = hasher{})
+                : key_hash_(key_hash),
+                  seed_(seed) {}
+
+        size_t operator()(const key_type &key) const {
+            if constexpr (std::is_convertible_v<const key_type &, std::string_view> &&
+                          !std::is_pointer_v<key_type>) {
+                std::string_view bytes = key;
+                return detail::hash_bytes(bytes.data(), bytes.size(), seed_);
+            } else {
+                return detail::multiply_mix(static_cast<uint64_t>(key_hash_(key)) ^ seed_, 0x9e3779b97f4a7c15ull);
+            }
+        }
+
+        template<typename PKey>
+        size_t operator()(const PKey &key) const {
+            if constexpr (std::is_convertible_v<const key_type &, std::string_view> &&
+                          std::is_convertible_v<const PKey &, std::string_view> &&
+                          !std::is_pointer_v<key_type>) {
+                std::string_view bytes = key;
+                return detail::hash_bytes(bytes.data(), bytes.size(), seed_);
+            } else {
+                return (*this)(static_cast<const key_type &>(key_type(key)));
+            }
+        }
+
+        uint64_t seed() const {
+            return seed_;
+        }
+
+        void reseed(uint64_t seed) {
+            seed_ = seed;
+        }
+    };
+
+    template<class TKey,
+            class KeyHash,
+            class KeyEqual>
+    class key_compare_traits {
+    public:
+        using key_type = TKey;
+        using hasher = KeyHash;
+        using key_equal = KeyEqual;
+
+        static constexpr const bool kTransparent =
+                detail::is_transparent<hasher>::value && detail::is_transparent<key_equal>::value;
+
+    private:
+        hasher key_hash_;
+        key_equal key_equal_;
+
+    public:
+        key_compare_traits() = default;
+
+        explicit key_compare_traits(const hasher &key_hash_arg) noexcept(
+        std::is_nothrow_copy_constructible_v<hasher> &&
+        std::is_nothrow_default_constructible_v<key_equal>)
+                : key_hash_(key_hash_arg), key_equal_() {}
+
+        explicit key_compare_traits(const key_equal &key_equal_arg) noexcept(
+        std::is_nothrow_copy_constructible_v<key_equal> &&
+        std::is_nothrow_default_constructible_v<hasher>)
+                : key_hash_(), key_equal_(key_equal_arg) {}
+
+        key_compare_traits(const hasher &key_hash_arg, const key_equal &key_equal_arg) noexcept(
+        std::is_nothrow_copy_constructible_v<hasher> &&
+        std::is_nothrow_copy_constructible_v<key_equal>)
+                : key_hash_(key_hash_arg), key_equal_(key_equal_arg) {}
+
+        key_compare_traits(const key_compare_traits &other) noexcept(
+        std::is_nothrow_copy_constructible_v<hasher> &&
+        std::is_nothrow_copy_constructible_v<key_equal>) = default;
 
         key_compare_traits(key_compare_traits &&other) noexcept(
         std::is_nothrow_move_constructible_v<hasher> &&
         std::is_nothrow_move_constructible_v<key_equal>) = default;
 
-        key_compare_traits &operator=(const key_compare_traits &other) noexcept(
-        std::is_nothrow_copy_assignable_v<hasher> &&
-        std::is_nothrow_copy_assignable_v<key_equal>) = default;
+        key_compare_traits &operator=(const key_compare_traits &other) noexcept(
+        std::is_nothrow_copy_assignable_v<hasher> &&
+        std::is_nothrow_copy_assignable_v<key_equal>) = default;
+
+        key_compare_traits &operator=(key_compare_traits &&other) noexcept(
+        std::is_nothrow_move_assignable_v<hasher> &&
+        std::is_nothrow_move_assignable_v<key_equal>) = default;
+
+        virtual ~key_compare_traits() = default;
+
+        size_t operator()(const key_type &key) const {
+            return key_hash_(key);
+        }
+
+        bool operator()(const key_type &first_key, const key_type &second_key) const {
+            return key_equal_(first_key, second_key);
+        }
+
+        template<typename PKey>
+        size_t operator()(const PKey &key) const {
+            return key_hash_(key);
+        }
+
+        template<typename PKey>
+        bool operator()(const key_type &first_key, const PKey &second_key) const {
+            return key_equal_(first_key, second_key);
+        }
+
+        hasher hash_function() const {
+            return key_hash_;
+        }
+
+        key_equal key_eq() const {
+            return key_equal_;
+        }
+
+        void reseed(uint64_t seed) {
+            key_hash_.reseed(seed);
+        }
+    };
+
+    template<class TKey,
+            class HashCompare,
+            class Allocator,
+            class GrowthPolicy,
+            class StoragePolicy = flat_storage>
+    class unordered_set_traits : public HashCompare {
+    private:
+        using size_type = typename GrowthPolicy::size_type;
+
+    public:
+        using key_compare = HashCompare;
+        using key_type = TKey;
+        using value_type = TKey;
+        using mutable_value_type = TKey;
+        using hasher = typename HashCompare::hasher;
+        using key_equal = typename HashCompare::key_equal;
+        using growth_policy = GrowthPolicy;
+        using storage_policy = StoragePolicy;
+        using allocator_type = Allocator;
+
+    private:
+        growth_policy growth_policy_;
+
+    public:
+        unordered_set_traits() = default;
+
+        explicit unordered_set_traits(const HashCompare &hash_traits) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_default_constructible_v<GrowthPolicy>)
+                : HashCompare(hash_traits), growth_policy_() {};
+
+        explicit unordered_set_traits(const GrowthPolicy &growth_policy) noexcept(
+        std::is_nothrow_default_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(), growth_policy_(growth_policy) {};
+
+        unordered_set_traits(const HashCompare &hash_traits, const GrowthPolicy &growth_policy) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(hash_traits), growth_policy_(growth_policy) {}
+
+        unordered_set_traits(const unordered_set_traits &other) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(other),
+                  growth_policy_(other.growth_policy_) {}
+
+        unordered_set_traits(unordered_set_traits &&other) noexcept(
+        std::is_nothrow_move_constructible_v<key_compare> &&
+        std::is_nothrow_move_constructible_v<GrowthPolicy>)
+                : HashCompare(std::move(other)),
+                  growth_policy_(std::move(other.growth_policy_)) {}
+
+        unordered_set_traits &operator=(const unordered_set_traits &other) noexcept(
+        std::is_nothrow_copy_assignable_v<key_compare> &&
+        std::is_nothrow_copy_assignable_v<GrowthPolicy>) {
+            if (this != &other) {
+                HashCompare::operator=(other);
+                growth_policy_ = other.growth_policy_;
+            }
+            return *this;
+        }
+
+        unordered_set_traits &operator=(unordered_set_traits &&other) noexcept(
+        std::is_nothrow_move_assignable_v<key_compare> &&
+        std::is_nothrow_move_assignable_v<GrowthPolicy>) {
+            if (this != &other) {
+                HashCompare::operator=(std::move(other));
+                growth_policy_ = std::move(other.growth_policy_);
+            }
+            return *this;
+        }
+
+        template<typename Type>
+        const Type &select_key(const Type &key) const {
+            return key;
+        }
+
+        template<typename PKey>
+        mutable_value_type make_value(PKey &&key) const {
+            return mutable_value_type(std::forward<PKey>(key));
+        }
+
+        size_type next_capacity(size_type current_capacity) const {
+            return growth_policy_(current_capacity);
+        }
+
+        size_type capacity_for(size_type needed_capacity, size_type current_capacity) const {
+            return detail::capacity_for(growth_policy_, needed_capacity, current_capacity);
+        }
+
+        size_type hash_to_index(size_t hash, size_type capacity) const {
+            return growth_policy_.index(hash, capacity);
+        }
+    };
+
+    template<class TKey,
+            class TValue,
+            class HashCompare,
+            class Allocator,
+            class GrowthPolicy,
+            class StoragePolicy = flat_storage>
+    class unordered_map_traits : public HashCompare {
+    private:
+        using size_type = typename GrowthPolicy::size_type;
+
+    public:
+        using key_compare = HashCompare;
+        using key_type = TKey;
+        using value_type = std::pair<const TKey, TValue>;
+        using mutable_value_type = std::pair<TKey, TValue>;
+        using hasher = typename HashCompare::hasher;
+        using key_equal = typename HashCompare::key_equal;
+        using growth_policy = GrowthPolicy;
+        using storage_policy = StoragePolicy;
+        using allocator_type = Allocator;
+
+    private:
+        growth_policy growth_policy_;
+
+    public:
+        unordered_map_traits() = default;
+
+        explicit unordered_map_traits(const HashCompare &hash_traits) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_default_constructible_v<GrowthPolicy>)
+                : HashCompare(hash_traits), growth_policy_() {};
+
+        explicit unordered_map_traits(const GrowthPolicy &growth_policy) noexcept(
+        std::is_nothrow_default_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(), growth_policy_(growth_policy) {};
+
+        unordered_map_traits(const HashCompare &hash_traits, const GrowthPolicy &growth_policy) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(hash_traits), growth_policy_(growth_policy) {}
+
+        unordered_map_traits(const unordered_map_traits &other) noexcept(
+        std::is_nothrow_copy_constructible_v<key_compare> &&
+        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
+                : HashCompare(other),
+                  growth_policy_(other.growth_policy_) {}
+
+        unordered_map_traits(unordered_map_traits &&other) noexcept(
+        std::is_nothrow_move_constructible_v<key_compare> &&
+        std::is_nothrow_move_constructible_v<GrowthPolicy>)
+                : HashCompare(std::move(other)),
+                  growth_policy_(std::move(other.growth_policy_)) {}
+
+        unordered_map_traits &operator=(const unordered_map_traits &other) noexcept(
+        std::is_nothrow_copy_assignable_v<key_compare> &&
+        std::is_nothrow_copy_assignable_v<GrowthPolicy>) {
+            if (this != &other) {
+                HashCompare::operator=(other);
+                growth_policy_ = other.growth_policy_;
+            }
+            return *this;
+        }
+
+        unordered_map_traits &operator=(unordered_map_traits &&other) noexcept(
+        std::is_nothrow_move_assignable_v<key_compare> &&
+        std::is_nothrow_move_assignable_v<GrowthPolicy>) {
+            if (this != &other) {
+                HashCompare::operator=(std::move(other));
+                growth_policy_ = std::move(other.growth_policy_);
+            }
+            return *this;
+        }
+
+        template<typename TFirst, typename TSecond>
+        const TFirst &select_key(const std::pair<TFirst, TSecond> &pair) const {
+            return pair.first;
+        }
+
+        template<typename PKey, typename ...Args>
+        mutable_value_type make_value(PKey &&key, Args &&...args) const {
+            return mutable_value_type(std::piecewise_construct,
+                                      std::forward_as_tuple(std::forward<PKey>(key)),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        size_type next_capacity(size_type current_capacity) const {
+            return growth_policy_(current_capacity);
+        }
+
+        size_type capacity_for(size_type needed_capacity, size_type current_capacity) const {
+            return detail::capacity_for(growth_policy_, needed_capacity, current_capacity);
+        }
+
+        size_type hash_to_index(size_t hash, size_type capacity) const {
+            return growth_policy_.index(hash, capacity);
+        }
+    };
+
+    template<class TKey,
+            class TValue,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>,
+            class GrowthPolicy = power_of_two_growth_policy,
+            class Instrumentation = no_instrumentation,
+            class StoragePolicy = flat_storage>
+    class unordered_map {
+        using hash_table = detail::hash_table<unordered_map_traits<TKey, TValue,
+                key_compare_traits<TKey, KeyHash, KeyEqual>,
+                Allocator, GrowthPolicy, StoragePolicy>, Instrumentation>;
+
+    public:
+        using key_type = TKey;
+        using value_type = typename hash_table::value_type;
+        using mapped_type = TValue;
+
+        using size_type = typename hash_table::size_type;
+        using difference_type = typename hash_table::difference_type;
+
+        using hasher = typename hash_table::hasher;
+        using key_equal = typename hash_table::key_equal;
+        using allocator_type = typename hash_table::allocator_type;
+
+        using reference = typename hash_table::reference;
+        using const_reference = typename hash_table::const_reference;
+
+        using pointer = typename hash_table::pointer;
+        using const_pointer = typename hash_table::const_pointer;
+
+        using iterator = typename hash_table::iterator;
+        using const_iterator = typename hash_table::const_iterator;
+
+        using range = typename hash_table::range;
+        using const_range = typename hash_table::const_range;
+
+        using cursor_type = typename hash_table::cursor;
+
+        using entry_type = typename hash_table::entry;
+
+        using stats_type = typename hash_table::stats_type;
+        using instrumentation_type = typename hash_table::instrumentation_type;
+
+        using rehash_event = typename hash_table::rehash_event;
+        using rehash_observer = typename hash_table::rehash_observer;
+
+    private:
+        hash_table hash_table_;
+
+    public:
+        unordered_map()
+                :
+                hash_table_() {}
+
+        explicit unordered_map(size_type capacity,
+                               const hasher &key_hash_function = hasher{},
+                               const key_equal &key_equal_function = key_equal{},
+                               const allocator_type &allocator = allocator_type{})
+                : hash_table_(capacity, key_hash_function, key_equal_function, allocator) {}
+
+        unordered_map(size_type capacity, const allocator_type &allocator)
+                : hash_table_(capacity, hasher{}, key_equal{}, allocator) {}
+
+        unordered_map(size_type capacity, const hasher &key_hash_function, const allocator_type &allocator)
+                : hash_table_(capacity, key_hash_function, key_equal{}, allocator) {}
+
+        explicit unordered_map(const allocator_type &allocator)
+                : hash_table_(0, hasher{}, key_equal{}, allocator) {}
+
+        template<typename InputIt>
+        unordered_map(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const key_equal &key_equal_function = key_equal{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, key_hash_function, key_equal_function, allocator) {}
+
+        template<typename InputIt>
+        unordered_map(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, hasher{}, key_equal{}, allocator) {}
+
+        template<typename InputIt>
+        unordered_map(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, key_hash_function, key_equal{}, allocator) {}
+
+        unordered_map(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const key_equal &key_equal_function = key_equal{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal_function, allocator) {}
+
+        unordered_map(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, hasher{}, key_equal{}, allocator) {}
+
+        unordered_map(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal{}, allocator) {}
+
+        unordered_map(const unordered_map &other) noexcept(std::is_nothrow_copy_constructible<hash_table>::value)
+                : hash_table_(other.hash_table_) {}
+
+        unordered_map(const unordered_map &other, const allocator_type &allocator)
+                : hash_table_(other.hash_table_, allocator) {}
+
+        unordered_map(unordered_map &&other) noexcept(std::is_nothrow_move_constructible<hash_table>::value)
+                : hash_table_(std::move(other.hash_table_)) {}
+
+        unordered_map(unordered_map &&other, const allocator_type &allocator)
+                : hash_table_(std::move(other.hash_table_), allocator) {}
+
+        unordered_map &operator=(const unordered_map &other) {
+            hash_table_ = other.hash_table_;
+            return *this;
+        }
+
+        unordered_map &operator=(unordered_map &&other) noexcept(std::is_nothrow_move_assignable<hash_table>::value) {
+            hash_table_ = std::move(other.hash_table_);
+            return *this;
+        }
+
+        unordered_map &operator=(std::initializer_list<value_type> list) {
+            hash_table_ = list;
+            return *this;
+        }
+
+        allocator_type get_allocator() const {
+            return hash_table_.get_allocator();
+        }
+
+        iterator begin() noexcept {
+            return hash_table_.begin();
+        }
+
+        iterator end() noexcept {
+            return hash_table_.end();
+        }
+
+        const_iterator begin() const noexcept {
+            return hash_table_.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return hash_table_.end();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return hash_table_.cbegin();
+        }
+
+        const_iterator cend() const noexcept {
+            return hash_table_.cend();
+        }
+
+        iterator rbegin() noexcept {
+            return hash_table_.rbegin();
+        }
+
+        iterator rend() noexcept {
+            return hash_table_.rend();
+        }
+
+        const_iterator rbegin() const noexcept {
+            return hash_table_.rbegin();
+        }
+
+        const_iterator rend() const noexcept {
+            return hash_table_.rend();
+        }
+
+        std::vector<range> split(size_type count) {
+            return hash_table_.split(count);
+        }
+
+        std::vector<const_range> split(size_type count) const {
+            return hash_table_.split(count);
+        }
+
+        template<typename ExecutionPolicy, typename Function>
+        void for_each(ExecutionPolicy &&policy, Function function) {
+            hash_table_.for_each(std::forward<ExecutionPolicy>(policy), std::move(function));
+        }
+
+        template<typename ExecutionPolicy, typename Function>
+        void for_each(ExecutionPolicy &&policy, Function function) const {
+            hash_table_.for_each(std::forward<ExecutionPolicy>(policy), std::move(function));
+        }
+
+        template<typename Function>
+        void for_each_occupied(Function function) {
+            hash_table_.for_each_occupied(std::move(function));
+        }
+
+        template<typename Function>
+        void for_each_occupied(Function function) const {
+            hash_table_.for_each_occupied(std::move(function));
+        }
+
+        bool empty() const noexcept {
+            return hash_table_.empty();
+        }
+
+        size_type size() const noexcept {
+            return hash_table_.size();
+        }
+
+        std::pair<iterator, bool> insert(const value_type &value) {
+            return hash_table_.insert(value);
+        }
+
+        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
+        std::pair<iterator, bool> insert(P &&value) {
+            return hash_table_.emplace(std::forward<P>(value));
+        }
+
+        std::pair<iterator, bool> insert(value_type &&value) {
+            return hash_table_.insert(std::move(value));
+        }
+
+        iterator insert(const_iterator hint, const value_type &value) {
+            return hash_table_.insert(hint, value);
+        }
+
+        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
+        iterator insert(const_iterator hint, P &&value) {
+            return hash_table_.emplace_hint(hint, std::forward<P>(value));
+        }
+
+        iterator insert(const_iterator hint, value_type &&value) {
+            return hash_table_.insert(hint, std::move(value));
+        }
+
+        template<class InputIt>
+        void insert(InputIt begin, InputIt end) {
+            hash_table_.insert(begin, end);
+        }
+
+        void insert(std::initializer_list<value_type> list) {
+            hash_table_.insert(list);
+        }
+
+        iterator insert_unique_unchecked(const value_type &value) {
+            return hash_table_.insert_unique_unchecked(value);
+        }
+
+        iterator insert_unique_unchecked(value_type &&value) {
+            return hash_table_.insert_unique_unchecked(std::move(value));
+        }
+
+        template<class InputIt>
+        void bulk_load_unique(InputIt begin, InputIt end) {
+            hash_table_.bulk_load_unique(begin, end);
+        }
+
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args &&... args) {
+            return hash_table_.emplace(std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args &&... args) {
+            return hash_table_.emplace_hint(hint, std::forward<Args>(args)...);
+        }
+
+        template<class K, class... Args>
+        std::pair<iterator, bool> try_emplace(K &&key, Args &&... args) {
+            return hash_table_.try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+        }
+
+        template<class K, class M>
+        std::pair<iterator, bool> insert_or_assign(K &&key, M &&object) {
+            auto result = hash_table_.try_emplace(std::forward<K>(key), std::forward<M>(object));
+            if (!result.second) {
+                result.first->second = std::forward<M>(object);
+            }
+            return result;
+        }
+
+        template<class K, class... Args>
+        iterator try_emplace_hint(const_iterator hint, K &&key, Args &&... args) {
+            (void) hint;
+            return try_emplace(std::forward<K>(key), std::forward<Args>(args)...).first;
+        }
+
+        entry_type entry(const key_type &key) {
+            return hash_table_.find_entry(key);
+        }
+
+        entry_type entry(key_type &&key) {
+            return hash_table_.find_entry(std::move(key));
+        }
+
+        iterator erase(iterator position) {
+            return hash_table_.erase(position);
+        }
+
+        iterator erase(const_iterator position) {
+            return hash_table_.erase(position);
+        }
+
+        iterator erase(const_iterator begin, const_iterator end) {
+            return hash_table_.erase(begin, end);
+        }
+
+        size_type erase(const key_type &key) {
+            return hash_table_.erase(key);
+        }
+
+        template<typename Predicate>
+        size_type erase_if(Predicate predicate) {
+            return hash_table_.erase_if(std::move(predicate));
+        }
+
+        cursor_type cursor() {
+            return hash_table_.make_cursor();
+        }
+
+        template<typename ForwardIt>
+        size_type erase_batch(ForwardIt begin, ForwardIt end) {
+            return hash_table_.erase_batch(begin, end);
+        }
+
+        void swap(unordered_map &other) {
+            other.hash_table_.swap(hash_table_);
+        }
+
+        mapped_type &operator[](const key_type &key) {
+            return try_emplace(key).first->second;
+        }
+
+        mapped_type &operator[](key_type &&key) {
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        template<class K>
+        mapped_type &operator[](K &&key) {
+            return try_emplace(std::forward<K>(key)).first->second;
+        }
+
+        mapped_type &at(const key_type &key) {
+            return hash_table_.find(key)->second;
+        }
+
+        const mapped_type &at(const key_type &key) const {
+            return hash_table_.find(key)->second;
+        }
+
+        size_type count(const key_type &key) const {
+            return hash_table_.count(key);
+        }
+
+        template<class K>
+        size_type count(const K &key) const {
+            return hash_table_.count(key);
+        }
+
+        iterator find(const key_type &key) {
+            return hash_table_.find(key);
+        }
+
+        const_iterator find(const key_type &key) const {
+            return hash_table_.find(key);
+        }
+
+        template<class K>
+        iterator find(const K &key) {
+            return hash_table_.find(key);
+        }
+
+        template<class K>
+        const_iterator find(const K &key) const {
+            return hash_table_.find(key);
+        }
+
+        bool contains(const key_type &key) const {
+            return hash_table_.contains(key);
+        }
+
+        template<class K>
+        bool contains(const K &key) const {
+            return hash_table_.contains(key);
+        }
+
+        std::pair<iterator, iterator> equal_range(const key_type &key) {
+            return hash_table_.equal_range(key);
+        }
+
+        std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+            const_iterator founded = find(key);
+            return hash_table_.equal_range(key);
+        }
+
+        //TODO: Two more methods of equal_range
+
+        size_type bucket_count() const {
+            return hash_table_.bucket_count();
+        }
+
+        size_type max_bucket_count() const {
+            return hash_table_.max_bucket_count();
+        }
+
+        stats_type stats() const {
+            return hash_table_.stats();
+        }
+
+        instrumentation_type &instrumentation() {
+            return hash_table_.instrumentation();
+        }
+
+        const instrumentation_type &instrumentation() const {
+            return hash_table_.instrumentation();
+        }
+
+        void set_rehash_observer(rehash_observer observer) {
+            hash_table_.set_rehash_observer(std::move(observer));
+        }
+
+        float load_factor() const {
+            return hash_table_.load_factor();
+        }
+
+        float max_load_factor() const {
+            return hash_table_.max_load_factor();
+        }
+
+        void max_load_factor(float load_factor) {
+            hash_table_.max_load_factor(load_factor);
+        }
+
+        void rehash(size_type new_capacity) {
+            hash_table_.rehash(new_capacity);
+        }
+
+        void reserve(size_type new_capacity) {
+            hash_table_.reserve(new_capacity);
+        }
+
+        hasher hash_function() const {
+            return hash_table_.hash_function();
+        }
+
+        key_equal key_eq() const {
+            return hash_table_.key_eq();
+        }
+
+        bool operator==(const unordered_map &other) const {
+            return hash_table_ == other.hash_table_;
+        }
+
+        bool operator!=(const hash_table &other) const {
+            return hash_table_ != other.hash_table_;
+        }
+
+        void clear() {
+            hash_table_.clear();
+        }
+    };
+
+    template<class TKey,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<TKey>,
+            class GrowthPolicy = power_of_two_growth_policy,
+            class Instrumentation = no_instrumentation,
+            class StoragePolicy = flat_storage>
+    class unordered_set {
+        using hash_table = detail::hash_table<unordered_set_traits<TKey, key_compare_traits<TKey, KeyHash, KeyEqual>,
+                Allocator, GrowthPolicy, StoragePolicy>, Instrumentation>;
+
+    public:
+        using key_type = TKey;
+        using value_type = typename hash_table::value_type;
+
+        using size_type = typename hash_table::size_type;
+        using difference_type = typename hash_table::difference_type;
+
+        using hasher = typename hash_table::hasher;
+        using key_equal = typename hash_table::key_equal;
+        using allocator_type = typename hash_table::allocator_type;
+
+        using reference = typename hash_table::reference;
+        using const_reference = typename hash_table::const_reference;
+
+        using pointer = typename hash_table::pointer;
+        using const_pointer = typename hash_table::const_pointer;
+
+        using iterator = typename hash_table::iterator;
+        using const_iterator = typename hash_table::const_iterator;
+
+        using range = typename hash_table::range;
+        using const_range = typename hash_table::const_range;
+
+        using cursor_type = typename hash_table::cursor;
+
+        using stats_type = typename hash_table::stats_type;
+        using instrumentation_type = typename hash_table::instrumentation_type;
+
+        using rehash_event = typename hash_table::rehash_event;
+        using rehash_observer = typename hash_table::rehash_observer;
+
+    private:
+        hash_table hash_table_;
+
+    public:
+        unordered_set()
+                :
+                hash_table_() {}
+
+        explicit unordered_set(size_type capacity,
+                               const hasher &key_hash_function = hasher{},
+                               const key_equal &key_equal_function = key_equal{},
+                               const allocator_type &allocator = allocator_type{})
+                : hash_table_(capacity, key_hash_function, key_equal_function, allocator) {}
+
+        unordered_set(size_type capacity, const allocator_type &allocator)
+                : hash_table_(capacity, hasher{}, key_equal{}, allocator) {}
 
-        key_compare_traits &operator=(key_compare_traits &&other) noexcept(
-        std::is_nothrow_move_assignable_v<hasher> &&
-        std::is_nothrow_move_assignable_v<key_equal>) = default;
+        unordered_set(size_type capacity, const hasher &key_hash_function, const allocator_type &allocator)
+                : hash_table_(capacity, key_hash_function, key_equal{}, allocator) {}
 
-        virtual ~key_compare_traits() = default;
+        explicit unordered_set(const allocator_type &allocator)
+                : hash_table_(0, hasher{}, key_equal{}, allocator) {}
 
-        size_t operator()(const key_type &key) const {
-            return key_hash_(key);
+        template<typename InputIt>
+        unordered_set(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const key_equal &key_equal_function = key_equal{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, key_hash_function, key_equal_function, allocator) {}
+
+        template<typename InputIt>
+        unordered_set(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, hasher{}, key_equal{}, allocator) {}
+
+        template<typename InputIt>
+        unordered_set(InputIt begin, InputIt end,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(begin, end, capacity, key_hash_function, key_equal{}, allocator) {}
+
+        unordered_set(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const key_equal &key_equal_function = key_equal{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal_function,
+                              allocator) {}
+
+        unordered_set(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, hasher{}, key_equal{}, allocator) {}
+
+        unordered_set(std::initializer_list<value_type> list,
+                      size_type capacity = 0,
+                      const hasher &key_hash_function = hasher{},
+                      const allocator_type &allocator = allocator_type{})
+                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal{}, allocator) {}
+
+        unordered_set(const unordered_set &other) noexcept(std::is_nothrow_copy_constructible<hash_table>::value)
+                : hash_table_(other.hash_table_) {}
+
+        unordered_set(const unordered_set &other, const allocator_type &allocator)
+                : hash_table_(other.hash_table_, allocator) {}
+
+        unordered_set(unordered_set &&other) noexcept(std::is_nothrow_move_constructible<hash_table>::value)
+                : hash_table_(std::move(other.hash_table_)) {}
+
+        unordered_set(unordered_set &&other, const allocator_type &allocator)
+                : hash_table_(std::move(other.hash_table_), allocator) {}
+
+        unordered_set &operator=(const unordered_set &other) {
+            hash_table_ = other.hash_table_;
+            return *this;
         }
 
-        bool operator()(const key_type &first_key, const key_type &second_key) const {
-            return key_equal_(first_key, second_key);
+        unordered_set &
+        operator=(unordered_set &&other) noexcept(std::is_nothrow_move_assignable<hash_table>::value) {
+            hash_table_ = std::move(other.hash_table_);
+            return *this;
         }
 
-        hasher hash_function() const {
-            return key_hash_;
+        unordered_set &operator=(std::initializer_list<value_type> list) {
+            hash_table_ = list;
+            return *this;
         }
 
-        key_equal key_eq() const {
-            return key_equal_;
+        allocator_type get_allocator() const {
+            return hash_table_.get_allocator();
         }
-    };
 
-    template<class TKey,
-            class HashCompare,
-            class Allocator,
-            class GrowthPolicy>
-    class unordered_set_traits : public HashCompare {
-    private:
-        using size_type = typename GrowthPolicy::size_type;
+        iterator begin() noexcept {
+            return hash_table_.begin();
+        }
 
-    public:
-        using key_compare = HashCompare;
-        using key_type = TKey;
-        using value_type = TKey;
-        using mutable_value_type = TKey;
-        using hasher = typename HashCompare::hasher;
-        using key_equal = typename HashCompare::key_equal;
-        using growth_policy = GrowthPolicy;
-        using allocator_type = Allocator;
+        iterator end() noexcept {
+            return hash_table_.end();
+        }
 
-    private:
-        growth_policy growth_policy_;
+        const_iterator begin() const noexcept {
+            return hash_table_.begin();
+        }
 
-    public:
-        unordered_set_traits() = default;
+        const_iterator end() const noexcept {
+            return hash_table_.end();
+        }
 
-        explicit unordered_set_traits(const HashCompare &hash_traits) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_default_constructible_v<GrowthPolicy>)
-                : HashCompare(hash_traits), growth_policy_() {};
+        const_iterator cbegin() const noexcept {
+            return hash_table_.cbegin();
+        }
+
+        const_iterator cend() const noexcept {
+            return hash_table_.cend();
+        }
+
+        iterator rbegin() noexcept {
+            return hash_table_.rbegin();
+        }
+
+        iterator rend() noexcept {
+            return hash_table_.rend();
+        }
+
+        const_iterator rbegin() const noexcept {
+            return hash_table_.rbegin();
+        }
+
+        const_iterator rend() const noexcept {
+            return hash_table_.rend();
+        }
+
+        std::vector<range> split(size_type count) {
+            return hash_table_.split(count);
+        }
+
+        std::vector<const_range> split(size_type count) const {
+            return hash_table_.split(count);
+        }
+
+        template<typename ExecutionPolicy, typename Function>
+        void for_each(ExecutionPolicy &&policy, Function function) {
+            hash_table_.for_each(std::forward<ExecutionPolicy>(policy), std::move(function));
+        }
+
+        template<typename ExecutionPolicy, typename Function>
+        void for_each(ExecutionPolicy &&policy, Function function) const {
+            hash_table_.for_each(std::forward<ExecutionPolicy>(policy), std::move(function));
+        }
+
+        template<typename Function>
+        void for_each_occupied(Function function) {
+            hash_table_.for_each_occupied(std::move(function));
+        }
+
+        template<typename Function>
+        void for_each_occupied(Function function) const {
+            hash_table_.for_each_occupied(std::move(function));
+        }
+
+        bool empty() const noexcept {
+            return hash_table_.empty();
+        }
+
+        size_type size() const noexcept {
+            return hash_table_.size();
+        }
+
+        std::pair<iterator, bool> insert(const value_type &value) {
+            return hash_table_.insert(value);
+        }
+
+        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
+        std::pair<iterator, bool> insert(P &&value) {
+            return hash_table_.emplace(std::forward<P>(value));
+        }
+
+        std::pair<iterator, bool> insert(value_type &&value) {
+            return hash_table_.insert(std::move(value));
+        }
+
+        iterator insert(const_iterator hint, const value_type &value) {
+            return hash_table_.insert(hint, value);
+        }
+
+        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
+        iterator insert(const_iterator hint, P &&value) {
+            return hash_table_.emplace_hint(hint, std::forward<P>(value));
+        }
+
+        iterator insert(const_iterator hint, value_type &&value) {
+            return hash_table_.insert(hint, std::move(value));
+        }
+
+        template<class InputIt>
+        void insert(InputIt begin, InputIt end) {
+            hash_table_.insert(begin, end);
+        }
+
+        void insert(std::initializer_list<value_type> list) {
+            hash_table_.insert(list);
+        }
+
+        iterator insert_unique_unchecked(const value_type &value) {
+            return hash_table_.insert_unique_unchecked(value);
+        }
+
+        iterator insert_unique_unchecked(value_type &&value) {
+            return hash_table_.insert_unique_unchecked(std::move(value));
+        }
+
+        template<class InputIt>
+        void bulk_load_unique(InputIt begin, InputIt end) {
+            hash_table_.bulk_load_unique(begin, end);
+        }
+
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args &&... args) {
+            return hash_table_.emplace(std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, Args &&... args) {
+            return hash_table_.emplace_hint(hint, std::forward<Args>(args)...);
+        }
+
+        iterator erase(iterator position) {
+            return hash_table_.erase(position);
+        }
+
+        iterator erase(const_iterator position) {
+            return hash_table_.erase(position);
+        }
+
+        iterator erase(const_iterator begin, const_iterator end) {
+            return hash_table_.erase(begin, end);
+        }
+
+        size_type erase(const key_type &key) {
+            return hash_table_.erase(key);
+        }
+
+        template<typename Predicate>
+        size_type erase_if(Predicate predicate) {
+            return hash_table_.erase_if(std::move(predicate));
+        }
+
+        cursor_type cursor() {
+            return hash_table_.make_cursor();
+        }
+
+        template<typename ForwardIt>
+        size_type erase_batch(ForwardIt begin, ForwardIt end) {
+            return hash_table_.erase_batch(begin, end);
+        }
+
+        void swap(unordered_set &other) {
+            other.hash_table_.swap(hash_table_);
+        }
+
+        size_type count(const key_type &key) const {
+            return hash_table_.count(key);
+        }
+
+        template<class K>
+        size_type count(const K &key) const {
+            return hash_table_.count(key);
+        }
+
+        iterator find(const key_type &key) {
+            return hash_table_.find(key);
+        }
+
+        const_iterator find(const key_type &key) const {
+            return hash_table_.find(key);
+        }
 
-        explicit unordered_set_traits(const GrowthPolicy &growth_policy) noexcept(
-        std::is_nothrow_default_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(), growth_policy_(growth_policy) {};
+        template<class K>
+        iterator find(const K &key) {
+            return hash_table_.find(key);
+        }
 
-        unordered_set_traits(const HashCompare &hash_traits, const GrowthPolicy &growth_policy) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(hash_traits), growth_policy_(growth_policy) {}
+        template<class K>
+        const_iterator find(const K &key) const {
+            return hash_table_.find(key);
+        }
 
-        unordered_set_traits(const unordered_set_traits &other) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(other),
-                  growth_policy_(other.growth_policy_) {}
+        bool contains(const key_type &key) const {
+            return hash_table_.contains(key);
+        }
 
-        unordered_set_traits(unordered_set_traits &&other) noexcept(
-        std::is_nothrow_move_constructible_v<key_compare> &&
-        std::is_nothrow_move_constructible_v<GrowthPolicy>)
-                : HashCompare(std::move(other)),
-                  growth_policy_(std::move(other.growth_policy_)) {}
+        template<class K>
+        bool contains(const K &key) const {
+            return hash_table_.contains(key);
+        }
 
-        unordered_set_traits &operator=(const unordered_set_traits &other) noexcept(
-        std::is_nothrow_copy_assignable_v<key_compare> &&
-        std::is_nothrow_copy_assignable_v<GrowthPolicy>) {
-            if (this != &other) {
-                HashCompare::operator=(other);
-                growth_policy_ = other.growth_policy_;
-            }
-            return *this;
+        std::pair<iterator, iterator> equal_range(const key_type &key) {
+            return hash_table_.equal_range(key);
         }
 
-        unordered_set_traits &operator=(unordered_set_traits &&other) noexcept(
-        std::is_nothrow_move_assignable_v<key_compare> &&
-        std::is_nothrow_move_assignable_v<GrowthPolicy>) {
-            if (this != &other) {
-                HashCompare::operator=(std::move(other));
-                growth_policy_ = std::move(other.growth_policy_);
-            }
-            return *this;
+        std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+            const_iterator founded = find(key);
+            return hash_table_.equal_range(key);
         }
 
-        template<typename Type>
-        const Type &select_key(const Type &key) const {
-            return key;
+        //TODO: Two more methods of equal_range
+
+        size_type bucket_count() const {
+            return hash_table_.bucket_count();
         }
 
-        size_type next_capacity(size_type current_capacity) const {
-            return growth_policy_(current_capacity);
+        size_type max_bucket_count() const {
+            return hash_table_.max_bucket_count();
         }
-    };
 
-    template<class TKey,
-            class TValue,
-            class HashCompare,
-            class Allocator,
-            class GrowthPolicy>
-    class unordered_map_traits : public HashCompare {
-    private:
-        using size_type = typename GrowthPolicy::size_type;
+        stats_type stats() const {
+            return hash_table_.stats();
+        }
 
-    public:
-        using key_compare = HashCompare;
-        using key_type = TKey;
-        using value_type = std::pair<const TKey, TValue>;
-        using mutable_value_type = std::pair<TKey, TValue>;
-        using hasher = typename HashCompare::hasher;
-        using key_equal = typename HashCompare::key_equal;
-        using growth_policy = GrowthPolicy;
-        using allocator_type = Allocator;
+        instrumentation_type &instrumentation() {
+            return hash_table_.instrumentation();
+        }
 
-    private:
-        growth_policy growth_policy_;
+        const instrumentation_type &instrumentation() const {
+            return hash_table_.instrumentation();
+        }
 
-    public:
-        unordered_map_traits() = default;
+        void set_rehash_observer(rehash_observer observer) {
+            hash_table_.set_rehash_observer(std::move(observer));
+        }
 
-        explicit unordered_map_traits(const HashCompare &hash_traits) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_default_constructible_v<GrowthPolicy>)
-                : HashCompare(hash_traits), growth_policy_() {};
+        float load_factor() const {
+            return hash_table_.load_factor();
+        }
 
-        explicit unordered_map_traits(const GrowthPolicy &growth_policy) noexcept(
-        std::is_nothrow_default_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(), growth_policy_(growth_policy) {};
+        float max_load_factor() const {
+            return hash_table_.max_load_factor();
+        }
 
-        unordered_map_traits(const HashCompare &hash_traits, const GrowthPolicy &growth_policy) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(hash_traits), growth_policy_(growth_policy) {}
+        void max_load_factor(float load_factor) {
+            hash_table_.max_load_factor(load_factor);
+        }
 
-        unordered_map_traits(const unordered_map_traits &other) noexcept(
-        std::is_nothrow_copy_constructible_v<key_compare> &&
-        std::is_nothrow_copy_constructible_v<GrowthPolicy>)
-                : HashCompare(other),
-                  growth_policy_(other.growth_policy_) {}
+        void rehash(size_type new_capacity) {
+            hash_table_.rehash(new_capacity);
+        }
 
-        unordered_map_traits(unordered_map_traits &&other) noexcept(
-        std::is_nothrow_move_constructible_v<key_compare> &&
-        std::is_nothrow_move_constructible_v<GrowthPolicy>)
-                : HashCompare(std::move(other)),
-                  growth_policy_(std::move(other.growth_policy_)) {}
+        void reserve(size_type new_capacity) {
+            hash_table_.reserve(new_capacity);
+        }
 
-        unordered_map_traits &operator=(const unordered_map_traits &other) noexcept(
-        std::is_nothrow_copy_assignable_v<key_compare> &&
-        std::is_nothrow_copy_assignable_v<GrowthPolicy>) {
-            if (this != &other) {
-                HashCompare::operator=(other);
-                growth_policy_ = other.growth_policy_;
-            }
-            return *this;
+        hasher hash_function() const {
+            return hash_table_.hash_function();
         }
 
-        unordered_map_traits &operator=(unordered_map_traits &&other) noexcept(
-        std::is_nothrow_move_assignable_v<key_compare> &&
-        std::is_nothrow_move_assignable_v<GrowthPolicy>) {
-            if (this != &other) {
-                HashCompare::operator=(std::move(other));
-                growth_policy_ = std::move(other.growth_policy_);
-            }
-            return *this;
+        key_equal key_eq() const {
+            return hash_table_.key_eq();
         }
 
-        template<typename TFirst, typename TSecond>
-        const TFirst &select_key(const std::pair<TFirst, TSecond> &pair) const {
-            return pair.first;
+        bool operator==(const unordered_set &other) const {
+            return hash_table_ == other.hash_table_;
         }
 
-        size_type next_capacity(size_type current_capacity) const {
-            return growth_policy_(current_capacity);
+        bool operator!=(const hash_table &other) const {
+            return hash_table_ != other.hash_table_;
+        }
+
+        void clear() {
+            hash_table_.clear();
         }
     };
 
+
     template<class TKey,
             class TValue,
             class KeyHash = std::hash<TKey>,
             class KeyEqual = std::equal_to<TKey>,
             class Allocator = std::allocator<std::pair<const TKey, TValue>>,
             class GrowthPolicy = power_of_two_growth_policy>
-    class unordered_map {
-        using hash_table = detail::hash_table<unordered_map_traits<TKey, TValue,
+    class segmented_map {
+        using hash_table = detail::segmented_hash_table<unordered_map_traits<TKey, TValue,
                 key_compare_traits<TKey, KeyHash, KeyEqual>,
-                Allocator, GrowthPolicy>>;
+                Allocator, GrowthPolicy>, no_instrumentation>;
 
     public:
         using key_type = TKey;
@@ -1712,133 +5429,40 @@ namespace ld {
         hash_table hash_table_;
 
     public:
-        unordered_map()
-                :
-                hash_table_() {}
+        segmented_map() = default;
 
-        explicit unordered_map(size_type capacity,
+        explicit segmented_map(size_type segment_capacity,
                                const hasher &key_hash_function = hasher{},
                                const key_equal &key_equal_function = key_equal{},
                                const allocator_type &allocator = allocator_type{})
-                : hash_table_(capacity, key_hash_function, key_equal_function, allocator) {}
-
-        unordered_map(size_type capacity, const allocator_type &allocator)
-                : hash_table_(capacity, hasher{}, key_equal{}, allocator) {}
-
-        unordered_map(size_type capacity, const hasher &key_hash_function, const allocator_type &allocator)
-                : hash_table_(capacity, key_hash_function, key_equal{}, allocator) {}
-
-        explicit unordered_map(const allocator_type &allocator)
-                : hash_table_(0, hasher{}, key_equal{}, allocator) {}
-
-        template<typename InputIt>
-        unordered_map(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const key_equal &key_equal_function = key_equal{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, key_hash_function, key_equal_function, allocator) {}
-
-        template<typename InputIt>
-        unordered_map(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, hasher{}, key_equal{}, allocator) {}
-
-        template<typename InputIt>
-        unordered_map(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, key_hash_function, key_equal{}, allocator) {}
-
-        unordered_map(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const key_equal &key_equal_function = key_equal{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal_function, allocator) {}
-
-        unordered_map(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, hasher{}, key_equal{}, allocator) {}
-
-        unordered_map(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal{}, allocator) {}
-
-        unordered_map(const unordered_map &other) noexcept(std::is_nothrow_copy_constructible<hash_table>::value)
-                : hash_table_(other.hash_table_) {}
-
-        unordered_map(const unordered_map &other, const allocator_type &allocator)
-                : hash_table_(other.hash_table_, allocator) {}
-
-        unordered_map(unordered_map &&other) noexcept(std::is_nothrow_move_constructible<hash_table>::value)
-                : hash_table_(std::move(other.hash_table_)) {}
-
-        unordered_map(unordered_map &&other, const allocator_type &allocator)
-                : hash_table_(std::move(other.hash_table_), allocator) {}
-
-        unordered_map &operator=(const unordered_map &other) {
-            hash_table_ = other.hash_table_;
-            return *this;
-        }
-
-        unordered_map &operator=(unordered_map &&other) noexcept(std::is_nothrow_move_assignable<hash_table>::value) {
-            hash_table_ = std::move(other.hash_table_);
-            return *this;
-        }
-
-        unordered_map &operator=(std::initializer_list<value_type> list) {
-            hash_table_ = list;
-            return *this;
-        }
+                : hash_table_(segment_capacity, key_hash_function, key_equal_function, allocator) {}
 
         allocator_type get_allocator() const {
             return hash_table_.get_allocator();
         }
 
-        iterator begin() noexcept {
-            return hash_table_.begin();
-        }
-
-        iterator end() noexcept {
-            return hash_table_.end();
-        }
-
-        const_iterator begin() const noexcept {
-            return hash_table_.begin();
-        }
-
-        const_iterator end() const noexcept {
-            return hash_table_.end();
-        }
-
-        const_iterator cbegin() const noexcept {
-            return hash_table_.cbegin();
+        iterator begin() noexcept {
+            return hash_table_.begin();
         }
 
-        const_iterator cend() const noexcept {
-            return hash_table_.cend();
+        const_iterator begin() const noexcept {
+            return hash_table_.begin();
         }
 
-        iterator rbegin() noexcept {
-            return hash_table_.rbegin();
+        const_iterator cbegin() const noexcept {
+            return hash_table_.cbegin();
         }
 
-        iterator rend() noexcept {
-            return hash_table_.rend();
+        iterator end() noexcept {
+            return hash_table_.end();
         }
 
-        const_iterator rbegin() const noexcept {
-            return hash_table_.rbegin();
+        const_iterator end() const noexcept {
+            return hash_table_.end();
         }
 
-        const_iterator rend() const noexcept {
-            return hash_table_.rend();
+        const_iterator cend() const noexcept {
+            return hash_table_.cend();
         }
 
         bool empty() const noexcept {
@@ -1853,77 +5477,40 @@ namespace ld {
             return hash_table_.insert(value);
         }
 
-        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
-        std::pair<iterator, bool> insert(P &&value) {
-            return hash_table_.emplace(std::forward<P>(value));
-        }
-
         std::pair<iterator, bool> insert(value_type &&value) {
             return hash_table_.insert(std::move(value));
         }
 
-        iterator insert(const_iterator hint, const value_type &value) {
-            return hash_table_.insert(hint, value);
-        }
-
-        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
-        iterator insert(const_iterator hint, P &&value) {
-            return hash_table_.emplace_hint(hint, std::forward<P>(value));
-        }
-
-        iterator insert(const_iterator hint, value_type &&value) {
-            return hash_table_.insert(hint, std::move(value));
-        }
-
         template<class InputIt>
         void insert(InputIt begin, InputIt end) {
             hash_table_.insert(begin, end);
         }
 
-        void insert(std::initializer_list<value_type> list) {
-            hash_table_.insert(list);
-        }
-
         template<class... Args>
         std::pair<iterator, bool> emplace(Args &&... args) {
             return hash_table_.emplace(std::forward<Args>(args)...);
         }
 
-        template<class... Args>
-        iterator emplace_hint(const_iterator hint, Args &&... args) {
-            return hash_table_.emplace_hint(hint, std::forward<Args>(args)...);
-        }
-
         template<class K, class... Args>
         std::pair<iterator, bool> try_emplace(K &&key, Args &&... args) {
-            return hash_table_.emplace(std::piecewise_construct,
-                                       std::forward_as_tuple(std::forward<K>(key)),
-                                       std::forward_as_tuple(std::forward<Args>(args)...));
-        }
-
-        template<class K, class... Args>
-        iterator try_emplace_hint(const_iterator hint, K &&key, Args &&... args) {
-            (void) hint;
-            return try_emplace(std::forward<K>(key), std::forward<Args>(args)...).first;
-        }
-
-        iterator erase(iterator position) {
-            return hash_table_.erase(position);
+            return hash_table_.try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
         }
 
-        iterator erase(const_iterator position) {
-            return hash_table_.erase(position);
+        size_type erase(const key_type &key) {
+            return hash_table_.erase(key);
         }
 
-        iterator erase(const_iterator begin, const_iterator end) {
-            return hash_table_.erase(begin, end);
+        template<typename Predicate>
+        size_type erase_if(Predicate predicate) {
+            return hash_table_.erase_if(std::move(predicate));
         }
 
-        size_type erase(const key_type &key) {
-            return hash_table_.erase(key);
+        template<typename ForwardIt>
+        size_type erase_batch(ForwardIt begin, ForwardIt end) {
+            return hash_table_.erase_batch(begin, end);
         }
 
-        void swap(unordered_map &other) {
+        void swap(segmented_map &other) {
             other.hash_table_.swap(hash_table_);
         }
 
@@ -1947,8 +5534,6 @@ namespace ld {
             return hash_table_.count(key);
         }
 
-        // TODO: One more methods of 'count'
-
         iterator find(const key_type &key) {
             return hash_table_.find(key);
         }
@@ -1957,31 +5542,20 @@ namespace ld {
             return hash_table_.find(key);
         }
 
-        //TODO: Two more methods of find
-
-        bool contains(const key_type &key) {
+        bool contains(const key_type &key) const {
             return hash_table_.contains(key);
         }
 
-        // TODO: One more methods of 'contains'
-
-        std::pair<iterator, iterator> equal_range(const key_type &key) {
-            return hash_table_.equal_range(key);
-        }
-
-        std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
-            const_iterator founded = find(key);
-            return hash_table_.equal_range(key);
-        }
-
-        //TODO: Two more methods of equal_range
-
         size_type bucket_count() const {
             return hash_table_.bucket_count();
         }
 
-        size_type max_bucket_count() const {
-            return hash_table_.max_bucket_count();
+        size_type segment_count() const {
+            return hash_table_.segment_count();
+        }
+
+        size_type segment_capacity() const {
+            return hash_table_.segment_capacity();
         }
 
         float load_factor() const {
@@ -1996,14 +5570,6 @@ namespace ld {
             hash_table_.max_load_factor(load_factor);
         }
 
-        void rehash(size_type new_capacity) {
-            hash_table_.rehash(new_capacity);
-        }
-
-        void reserve(size_type new_capacity) {
-            hash_table_.reserve(new_capacity);
-        }
-
         hasher hash_function() const {
             return hash_table_.hash_function();
         }
@@ -2012,14 +5578,6 @@ namespace ld {
             return hash_table_.key_eq();
         }
 
-        bool operator==(const unordered_map &other) const {
-            return hash_table_ == other.hash_table_;
-        }
-
-        bool operator!=(const hash_table &other) const {
-            return hash_table_ != other.hash_table_;
-        }
-
         void clear() {
             hash_table_.clear();
         }
@@ -2030,9 +5588,10 @@ namespace ld {
             class KeyEqual = std::equal_to<TKey>,
             class Allocator = std::allocator<TKey>,
             class GrowthPolicy = power_of_two_growth_policy>
-    class unordered_set {
-        using hash_table = detail::hash_table<unordered_set_traits<TKey, key_compare_traits<TKey, KeyHash, KeyEqual>,
-                Allocator, GrowthPolicy>>;
+    class segmented_set {
+        using hash_table = detail::segmented_hash_table<unordered_set_traits<TKey,
+                key_compare_traits<TKey, KeyHash, KeyEqual>,
+                Allocator, GrowthPolicy>, no_instrumentation>;
 
     public:
         using key_type = TKey;
@@ -2058,292 +5617,681 @@ namespace ld {
         hash_table hash_table_;
 
     public:
-        unordered_set()
-                :
-                hash_table_() {}
+        segmented_set() = default;
 
-        explicit unordered_set(size_type capacity,
+        explicit segmented_set(size_type segment_capacity,
                                const hasher &key_hash_function = hasher{},
                                const key_equal &key_equal_function = key_equal{},
                                const allocator_type &allocator = allocator_type{})
-                : hash_table_(capacity, key_hash_function, key_equal_function, allocator) {}
+                : hash_table_(segment_capacity, key_hash_function, key_equal_function, allocator) {}
 
-        unordered_set(size_type capacity, const allocator_type &allocator)
-                : hash_table_(capacity, hasher{}, key_equal{}, allocator) {}
+        allocator_type get_allocator() const {
+            return hash_table_.get_allocator();
+        }
 
-        unordered_set(size_type capacity, const hasher &key_hash_function, const allocator_type &allocator)
-                : hash_table_(capacity, key_hash_function, key_equal{}, allocator) {}
+        iterator begin() noexcept {
+            return hash_table_.begin();
+        }
 
-        explicit unordered_set(const allocator_type &allocator)
-                : hash_table_(0, hasher{}, key_equal{}, allocator) {}
+        const_iterator begin() const noexcept {
+            return hash_table_.begin();
+        }
 
-        template<typename InputIt>
-        unordered_set(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const key_equal &key_equal_function = key_equal{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, key_hash_function, key_equal_function, allocator) {}
+        const_iterator cbegin() const noexcept {
+            return hash_table_.cbegin();
+        }
 
-        template<typename InputIt>
-        unordered_set(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, hasher{}, key_equal{}, allocator) {}
+        iterator end() noexcept {
+            return hash_table_.end();
+        }
 
-        template<typename InputIt>
-        unordered_set(InputIt begin, InputIt end,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(begin, end, capacity, key_hash_function, key_equal{}, allocator) {}
+        const_iterator end() const noexcept {
+            return hash_table_.end();
+        }
 
-        unordered_set(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const key_equal &key_equal_function = key_equal{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal_function,
-                              allocator) {}
+        const_iterator cend() const noexcept {
+            return hash_table_.cend();
+        }
 
-        unordered_set(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, hasher{}, key_equal{}, allocator) {}
+        bool empty() const noexcept {
+            return hash_table_.empty();
+        }
 
-        unordered_set(std::initializer_list<value_type> list,
-                      size_type capacity = 0,
-                      const hasher &key_hash_function = hasher{},
-                      const allocator_type &allocator = allocator_type{})
-                : hash_table_(list.begin(), list.end(), capacity, key_hash_function, key_equal{}, allocator) {}
+        size_type size() const noexcept {
+            return hash_table_.size();
+        }
+
+        std::pair<iterator, bool> insert(const value_type &value) {
+            return hash_table_.insert(value);
+        }
+
+        std::pair<iterator, bool> insert(value_type &&value) {
+            return hash_table_.insert(std::move(value));
+        }
+
+        template<class InputIt>
+        void insert(InputIt begin, InputIt end) {
+            hash_table_.insert(begin, end);
+        }
+
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args &&... args) {
+            return hash_table_.emplace(std::forward<Args>(args)...);
+        }
+
+        size_type erase(const key_type &key) {
+            return hash_table_.erase(key);
+        }
+
+        template<typename Predicate>
+        size_type erase_if(Predicate predicate) {
+            return hash_table_.erase_if(std::move(predicate));
+        }
+
+        template<typename ForwardIt>
+        size_type erase_batch(ForwardIt begin, ForwardIt end) {
+            return hash_table_.erase_batch(begin, end);
+        }
+
+        void swap(segmented_set &other) {
+            other.hash_table_.swap(hash_table_);
+        }
+
+        size_type count(const key_type &key) const {
+            return hash_table_.count(key);
+        }
+
+        iterator find(const key_type &key) {
+            return hash_table_.find(key);
+        }
+
+        const_iterator find(const key_type &key) const {
+            return hash_table_.find(key);
+        }
+
+        bool contains(const key_type &key) const {
+            return hash_table_.contains(key);
+        }
+
+        size_type bucket_count() const {
+            return hash_table_.bucket_count();
+        }
+
+        size_type segment_count() const {
+            return hash_table_.segment_count();
+        }
+
+        size_type segment_capacity() const {
+            return hash_table_.segment_capacity();
+        }
+
+        float load_factor() const {
+            return hash_table_.load_factor();
+        }
+
+        float max_load_factor() const {
+            return hash_table_.max_load_factor();
+        }
+
+        void max_load_factor(float load_factor) {
+            hash_table_.max_load_factor(load_factor);
+        }
+
+        hasher hash_function() const {
+            return hash_table_.hash_function();
+        }
+
+        key_equal key_eq() const {
+            return hash_table_.key_eq();
+        }
+
+        void clear() {
+            hash_table_.clear();
+        }
+    };
+
+
+    // Keeps each field in its own contiguous column. The Robin Hood index maps a key to its row, and erase moves the
+    // last row into the hole, so rows stay dense and a column can be scanned as a plain array.
+    template<class TKey,
+            class KeyHash,
+            class KeyEqual,
+            class ...Fields>
+    class basic_columnar_map {
+        static_assert(sizeof...(Fields) > 0, "columnar_map needs at least one field");
 
-        unordered_set(const unordered_set &other) noexcept(std::is_nothrow_copy_constructible<hash_table>::value)
-                : hash_table_(other.hash_table_) {}
+        using index_map = unordered_map<TKey, size_t, KeyHash, KeyEqual>;
 
-        unordered_set(const unordered_set &other, const allocator_type &allocator)
-                : hash_table_(other.hash_table_, allocator) {}
+    public:
+        using key_type = TKey;
+        using size_type = size_t;
+        using hasher = KeyHash;
+        using key_equal = KeyEqual;
 
-        unordered_set(unordered_set &&other) noexcept(std::is_nothrow_move_constructible<hash_table>::value)
-                : hash_table_(std::move(other.hash_table_)) {}
+        template<size_t Column>
+        using field_type = std::tuple_element_t<Column, std::tuple<Fields...>>;
 
-        unordered_set(unordered_set &&other, const allocator_type &allocator)
-                : hash_table_(std::move(other.hash_table_), allocator) {}
+        static constexpr const size_type npos = static_cast<size_type>(-1);
 
-        unordered_set &operator=(const unordered_set &other) {
-            hash_table_ = other.hash_table_;
-            return *this;
+    private:
+        index_map index_;
+        std::vector<key_type> keys_;
+        std::tuple<std::vector<Fields>...> columns_;
+
+        template<typename Function>
+        void _for_each_column(Function &&function) {
+            std::apply([&](auto &...column) { (function(column), ...); }, columns_);
         }
 
-        unordered_set &
-        operator=(unordered_set &&other) noexcept(std::is_nothrow_move_assignable<hash_table>::value) {
-            hash_table_ = std::move(other.hash_table_);
-            return *this;
+        // Drops rows from the back, pop_back needs neither a default constructor nor assignment.
+        void _truncate(size_type rows) {
+            auto truncate = [rows](auto &column) {
+                while (column.size() > rows) {
+                    column.pop_back();
+                }
+            };
+            truncate(keys_);
+            _for_each_column(truncate);
         }
 
-        unordered_set &operator=(std::initializer_list<value_type> list) {
-            hash_table_ = list;
-            return *this;
+    public:
+        basic_columnar_map() = default;
+
+        explicit basic_columnar_map(size_type capacity,
+                                    const hasher &key_hash_function = hasher{},
+                                    const key_equal &key_equal_function = key_equal{})
+                : index_(0, key_hash_function, key_equal_function) {
+            reserve(capacity);
         }
 
-        allocator_type get_allocator() const {
-            return hash_table_.get_allocator();
+        // Inserts a row with value-initialized fields unless the key is already present.
+        std::pair<size_type, bool> insert(const key_type &key) {
+            return insert(key, Fields()...);
         }
 
-        iterator begin() noexcept {
-            return hash_table_.begin();
+        std::pair<size_type, bool> insert(const key_type &key, const Fields &...fields) {
+            size_type row = keys_.size();
+            auto insertion_info = index_.try_emplace(key, row);
+            if (!insertion_info.second) {
+                return std::make_pair(insertion_info.first->second, false);
+            }
+            try {
+                keys_.push_back(key);
+                std::apply([&](auto &...column) { (column.push_back(fields), ...); }, columns_);
+            } catch (...) {
+                _truncate(row);
+                index_.erase(key);
+                throw;
+            }
+            return std::make_pair(row, true);
         }
 
-        iterator end() noexcept {
-            return hash_table_.end();
+        size_type erase(const key_type &key) {
+            auto position = index_.find(key);
+            if (position == index_.end()) {
+                return 0;
+            }
+            size_type row = position->second;
+            size_type last = keys_.size() - 1;
+            index_.erase(position);
+            if (row != last) {
+                keys_[row] = std::move(keys_[last]);
+                _for_each_column([row, last](auto &column) { column[row] = std::move(column[last]); });
+                index_.find(keys_[row])->second = row;
+            }
+            _truncate(last);
+            return 1;
         }
 
-        const_iterator begin() const noexcept {
-            return hash_table_.begin();
+        // Row of the key, or npos. Rows change only when an erase moves the last row.
+        size_type find(const key_type &key) const {
+            auto position = index_.find(key);
+            return position == index_.end() ? npos : position->second;
         }
 
-        const_iterator end() const noexcept {
-            return hash_table_.end();
+        bool contains(const key_type &key) const {
+            return index_.contains(key);
         }
 
-        const_iterator cbegin() const noexcept {
-            return hash_table_.cbegin();
+        template<size_t Column>
+        field_type<Column> &get(size_type row) {
+            return std::get<Column>(columns_)[row];
         }
 
-        const_iterator cend() const noexcept {
-            return hash_table_.cend();
+        template<size_t Column>
+        const field_type<Column> &get(size_type row) const {
+            return std::get<Column>(columns_)[row];
         }
 
-        iterator rbegin() noexcept {
-            return hash_table_.rbegin();
+        // The first of size() contiguous values of the field.
+        template<size_t Column>
+        field_type<Column> *column() noexcept {
+            return std::get<Column>(columns_).data();
         }
 
-        iterator rend() noexcept {
-            return hash_table_.rend();
+        template<size_t Column>
+        const field_type<Column> *column() const noexcept {
+            return std::get<Column>(columns_).data();
         }
 
-        const_iterator rbegin() const noexcept {
-            return hash_table_.rbegin();
+        const key_type &key(size_type row) const {
+            return keys_[row];
         }
 
-        const_iterator rend() const noexcept {
-            return hash_table_.rend();
+        const key_type *keys() const noexcept {
+            return keys_.data();
         }
 
         bool empty() const noexcept {
-            return hash_table_.empty();
+            return keys_.empty();
         }
 
         size_type size() const noexcept {
-            return hash_table_.size();
+            return keys_.size();
         }
 
-        std::pair<iterator, bool> insert(const value_type &value) {
-            return hash_table_.insert(value);
+        void reserve(size_type rows) {
+            index_.reserve(static_cast<size_type>(static_cast<float>(rows) / index_.max_load_factor()));
+            keys_.reserve(rows);
+            _for_each_column([rows](auto &column) { column.reserve(rows); });
         }
 
-        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
-        std::pair<iterator, bool> insert(P &&value) {
-            return hash_table_.emplace(std::forward<P>(value));
+        void clear() {
+            index_.clear();
+            keys_.clear();
+            _for_each_column([](auto &column) { column.clear(); });
         }
+    };
 
-        std::pair<iterator, bool> insert(value_type &&value) {
-            return hash_table_.insert(std::move(value));
+    template<class TKey, class ...Fields>
+    using columnar_map = basic_columnar_map<TKey, std::hash<TKey>, std::equal_to<TKey>, Fields...>;
+
+    // Set of unsigned integers that stores only part of each key, in the style of a quotient filter. Keys go through
+    // an invertible mixer, the top log2(capacity) bits of the result are the home slot, and a bit-packed slot keeps
+    // the remaining bits next to the probe distance. Iteration rebuilds the keys, so it yields values, not references.
+    template<class TKey = uint64_t, class Allocator = std::allocator<uint64_t>>
+    class quotient_set {
+        static_assert(std::is_unsigned_v<TKey> && sizeof(TKey) <= sizeof(uint64_t),
+                      "quotient_set stores unsigned integers of up to 64 bits");
+
+        class quotient_set_iterator;
+
+        using word_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t>;
+        using words = detail::array<uint64_t, word_allocator>;
+
+        static constexpr const float kMinLoadFactor = 0.1f;
+        static constexpr const float kMaxLoadFactor = 0.95f;
+        static constexpr const size_t kWordBits = 64;
+        // A slot stores distance + 1, zero marks it empty.
+        static constexpr const size_t kDistanceBits = 8;
+        static constexpr const uint64_t kDistanceMask = (uint64_t(1) << kDistanceBits) - 1;
+        static constexpr const uint64_t kMaxDistance = kDistanceMask - 1;
+        // Keeps a slot within one 64-bit word's worth of bits.
+        static constexpr const size_t kMinCapacityBits = kDistanceBits;
+
+    public:
+        using key_type = TKey;
+        using value_type = TKey;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using allocator_type = Allocator;
+
+        using iterator = quotient_set_iterator;
+        using const_iterator = quotient_set_iterator;
+
+    private:
+        float load_factor_{LD_ROBIN_HOOD_DEFAULT_LOAD_FACTOR};
+        size_type size_{0};
+        size_t capacity_bits_{0};
+        size_t slot_bits_{0};
+        words words_;
+
+        static uint64_t _mix(uint64_t key) {
+            key ^= key >> 30u;
+            key *= 0xbf58476d1ce4e5b9ull;
+            key ^= key >> 27u;
+            key *= 0x94d049bb133111ebull;
+            key ^= key >> 31u;
+            return key;
         }
 
-        iterator insert(const_iterator hint, const value_type &value) {
-            return hash_table_.insert(hint, value);
+        static uint64_t _unmix(uint64_t mixed) {
+            mixed ^= (mixed >> 31u) ^ (mixed >> 62u);
+            mixed *= 0x319642b2d24d8ec3ull;
+            mixed ^= (mixed >> 27u) ^ (mixed >> 54u);
+            mixed *= 0x96de1b173f119089ull;
+            mixed ^= (mixed >> 30u) ^ (mixed >> 60u);
+            return mixed;
         }
 
-        template<class P, typename std::enable_if<std::is_constructible<value_type, P &&>::value>::type * = nullptr>
-        iterator insert(const_iterator hint, P &&value) {
-            return hash_table_.emplace_hint(hint, std::forward<P>(value));
+        size_type _capacity() const {
+            return capacity_bits_ == 0 ? 0 : size_type(1) << capacity_bits_;
         }
 
-        iterator insert(const_iterator hint, value_type &&value) {
-            return hash_table_.insert(hint, std::move(value));
+        size_t _remainder_bits() const {
+            return kWordBits - capacity_bits_;
         }
 
-        template<class InputIt>
-        void insert(InputIt begin, InputIt end) {
-            hash_table_.insert(begin, end);
+        uint64_t _slot_mask() const {
+            return slot_bits_ == kWordBits ? ~uint64_t(0) : (uint64_t(1) << slot_bits_) - 1;
         }
 
-        void insert(std::initializer_list<value_type> list) {
-            hash_table_.insert(list);
+        uint64_t _load(size_type index) const {
+            size_t bit = index * slot_bits_;
+            size_t word = bit / kWordBits;
+            size_t shift = bit % kWordBits;
+            uint64_t slot = words_[word] >> shift;
+            if (shift + slot_bits_ > kWordBits) {
+                slot |= words_[word + 1] << (kWordBits - shift);
+            }
+            return slot & _slot_mask();
         }
 
-        template<class... Args>
-        std::pair<iterator, bool> emplace(Args &&... args) {
-            return hash_table_.emplace(std::forward<Args>(args)...);
+        void _store(size_type index, uint64_t slot) {
+            size_t bit = index * slot_bits_;
+            size_t word = bit / kWordBits;
+            size_t shift = bit % kWordBits;
+            uint64_t mask = _slot_mask();
+            words_[word] = (words_[word] & ~(mask << shift)) | (slot << shift);
+            if (shift + slot_bits_ > kWordBits) {
+                size_t spill = kWordBits - shift;
+                words_[word + 1] = (words_[word + 1] & ~(mask >> spill)) | (slot >> spill);
+            }
         }
 
-        template<class... Args>
-        iterator emplace_hint(const_iterator hint, Args &&... args) {
-            return hash_table_.emplace_hint(hint, std::forward<Args>(args)...);
+        size_type _next_index(size_type index) const {
+            return (index + 1) & (_capacity() - 1);
         }
 
-        iterator erase(iterator position) {
-            return hash_table_.erase(position);
+        uint64_t _mixed_at(size_type index, uint64_t slot) const {
+            uint64_t distance = (slot & kDistanceMask) - 1;
+            uint64_t home = (index - distance) & (_capacity() - 1);
+            return (home << _remainder_bits()) | (slot >> kDistanceBits);
         }
 
-        iterator erase(const_iterator position) {
-            return hash_table_.erase(position);
+        size_type _find(uint64_t mixed) const {
+            if (size_ == 0) {
+                return _capacity();
+            }
+            size_type index = mixed >> _remainder_bits();
+            uint64_t remainder = mixed & ((uint64_t(1) << _remainder_bits()) - 1);
+            uint64_t distance = 0;
+
+            while (true) {
+                uint64_t slot = _load(index);
+                uint64_t resident = (slot & kDistanceMask) - 1;
+                if (slot == 0 || resident < distance) {
+                    return _capacity();
+                }
+                if (resident == distance && (slot >> kDistanceBits) == remainder) {
+                    return index;
+                }
+                index = _next_index(index);
+                distance++;
+            }
         }
 
-        iterator erase(const_iterator begin, const_iterator end) {
-            return hash_table_.erase(begin, end);
+        // Places a key that isn't in the set. Returns false when a probe would run out of distance bits, mixed then
+        // holds the key that is still homeless, which is not necessarily the one passed in.
+        bool _place(uint64_t &mixed) {
+            size_type index = mixed >> _remainder_bits();
+            uint64_t remainder = mixed & ((uint64_t(1) << _remainder_bits()) - 1);
+            uint64_t distance = 0;
+
+            while (true) {
+                if (distance > kMaxDistance) {
+                    uint64_t home = (index - distance) & (_capacity() - 1);
+                    mixed = (home << _remainder_bits()) | remainder;
+                    return false;
+                }
+                uint64_t slot = _load(index);
+                if (slot == 0) {
+                    _store(index, (remainder << kDistanceBits) | (distance + 1));
+                    return true;
+                }
+                uint64_t resident = (slot & kDistanceMask) - 1;
+                if (resident < distance) {
+                    _store(index, (remainder << kDistanceBits) | (distance + 1));
+                    remainder = slot >> kDistanceBits;
+                    distance = resident;
+                }
+                index = _next_index(index);
+                distance++;
+            }
         }
 
-        size_type erase(const key_type &key) {
-            return hash_table_.erase(key);
+        size_type _size_to_grow() const {
+            size_type capacity = _capacity();
+            if (capacity == 0) {
+                return 0;
+            }
+            return std::min(static_cast<size_type>(load_factor_ * capacity), capacity - 1);
         }
 
-        void swap(unordered_set &other) {
-            other.hash_table_.swap(hash_table_);
+        void _rehash(size_t capacity_bits) {
+            quotient_set rehashed(get_allocator());
+            rehashed.load_factor_ = load_factor_;
+            rehashed.capacity_bits_ = capacity_bits;
+            rehashed.slot_bits_ = kWordBits - capacity_bits + kDistanceBits;
+            rehashed.words_ = words(rehashed._capacity() * rehashed.slot_bits_ / kWordBits + 1, get_allocator());
+
+            for (size_type index = 0; index < _capacity(); ++index) {
+                uint64_t slot = _load(index);
+                if (slot != 0) {
+                    uint64_t mixed = _mixed_at(index, slot);
+                    while (!rehashed._place(mixed)) {
+                        rehashed._rehash(rehashed.capacity_bits_ + 1);
+                    }
+                }
+            }
+            rehashed.size_ = size_;
+            swap(rehashed);
         }
 
-        size_type count(const key_type &key) const {
-            return hash_table_.count(key);
+        void _grow() {
+            _rehash(capacity_bits_ == 0 ? kMinCapacityBits : capacity_bits_ + 1);
         }
 
-        // TODO: One more methods of 'count'
+    public:
+        quotient_set() = default;
+
+        explicit quotient_set(const allocator_type &allocator)
+                : words_(word_allocator(allocator)) {}
 
-        iterator find(const key_type &key) {
-            return hash_table_.find(key);
+        explicit quotient_set(size_type capacity, const allocator_type &allocator = allocator_type{})
+                : words_(word_allocator(allocator)) {
+            reserve(capacity);
         }
 
-        const_iterator find(const key_type &key) const {
-            return hash_table_.find(key);
+        template<typename InputIt>
+        quotient_set(InputIt begin, InputIt end, const allocator_type &allocator = allocator_type{})
+                : words_(word_allocator(allocator)) {
+            insert(begin, end);
         }
 
-        //TODO: Two more methods of find
+        quotient_set(std::initializer_list<key_type> list, const allocator_type &allocator = allocator_type{})
+                : quotient_set(list.begin(), list.end(), allocator) {}
 
-        bool contains(const key_type &key) {
-            return hash_table_.contains(key);
+        allocator_type get_allocator() const {
+            return allocator_type(words_.get_allocator());
         }
 
-        // TODO: One more methods of 'contains'
+        // Returns whether the key was inserted.
+        bool insert(key_type key) {
+            uint64_t mixed = _mix(key);
+            if (_find(mixed) != _capacity()) {
+                return false;
+            }
+            if (size_ >= _size_to_grow()) {
+                _grow();
+            }
+            while (!_place(mixed)) {
+                _grow();
+            }
+            size_++;
+            return true;
+        }
 
-        std::pair<iterator, iterator> equal_range(const key_type &key) {
-            return hash_table_.equal_range(key);
+        template<typename InputIt>
+        void insert(InputIt begin, InputIt end) {
+            for (; begin != end; ++begin) {
+                insert(*begin);
+            }
         }
 
-        std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
-            const_iterator founded = find(key);
-            return hash_table_.equal_range(key);
+        size_type erase(key_type key) {
+            size_type index = _find(_mix(key));
+            if (index == _capacity()) {
+                return 0;
+            }
+            size_type next = _next_index(index);
+            uint64_t slot;
+            while ((slot = _load(next)) != 0 && (slot & kDistanceMask) > 1) {
+                _store(index, slot - 1);
+                index = next;
+                next = _next_index(next);
+            }
+            _store(index, 0);
+            size_--;
+            return 1;
         }
 
-        //TODO: Two more methods of equal_range
+        bool contains(key_type key) const {
+            return _find(_mix(key)) != _capacity();
+        }
 
-        size_type bucket_count() const {
-            return hash_table_.bucket_count();
+        size_type count(key_type key) const {
+            return contains(key) ? 1 : 0;
         }
 
-        size_type max_bucket_count() const {
-            return hash_table_.max_bucket_count();
+        const_iterator begin() const {
+            return const_iterator(this, 0);
         }
 
-        float load_factor() const {
-            return hash_table_.load_factor();
+        const_iterator cbegin() const {
+            return begin();
         }
 
-        float max_load_factor() const {
-            return hash_table_.max_load_factor();
+        const_iterator end() const {
+            return const_iterator(this, _capacity());
         }
 
-        void max_load_factor(float load_factor) {
-            hash_table_.max_load_factor(load_factor);
+        const_iterator cend() const {
+            return end();
         }
 
-        void rehash(size_type new_capacity) {
-            hash_table_.rehash(new_capacity);
+        bool empty() const noexcept {
+            return size_ == 0;
         }
 
-        void reserve(size_type new_capacity) {
-            hash_table_.reserve(new_capacity);
+        size_type size() const noexcept {
+            return size_;
         }
 
-        hasher hash_function() const {
-            return hash_table_.hash_function();
+        size_type bucket_count() const noexcept {
+            return _capacity();
         }
 
-        key_equal key_eq() const {
-            return hash_table_.key_eq();
+        size_type allocated_bytes() const noexcept {
+            return words_.size() * sizeof(uint64_t);
         }
 
-        bool operator==(const unordered_set &other) const {
-            return hash_table_ == other.hash_table_;
+        float load_factor() const {
+            return _capacity() == 0 ? 0.f : static_cast<float>(size_) / static_cast<float>(_capacity());
         }
 
-        bool operator!=(const hash_table &other) const {
-            return hash_table_ != other.hash_table_;
+        float max_load_factor() const {
+            return load_factor_;
+        }
+
+        void max_load_factor(float load_factor) {
+            load_factor_ = std::clamp(load_factor, kMinLoadFactor, kMaxLoadFactor);
+            while (size_ > _size_to_grow()) {
+                _grow();
+            }
+        }
+
+        // Makes room for count keys without growing.
+        void reserve(size_type count) {
+            size_t capacity_bits = std::max(capacity_bits_, kMinCapacityBits);
+            while (std::min(static_cast<size_type>(load_factor_ * (size_type(1) << capacity_bits)),
+                            (size_type(1) << capacity_bits) - 1) < count) {
+                capacity_bits++;
+            }
+            if (capacity_bits != capacity_bits_) {
+                _rehash(capacity_bits);
+            }
         }
 
         void clear() {
-            hash_table_.clear();
+            words_ = words(word_allocator(get_allocator()));
+            capacity_bits_ = 0;
+            slot_bits_ = 0;
+            size_ = 0;
         }
-    };
 
+        void swap(quotient_set &other) {
+            std::swap(load_factor_, other.load_factor_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_bits_, other.capacity_bits_);
+            std::swap(slot_bits_, other.slot_bits_);
+            std::swap(words_, other.words_);
+        }
+
+    private:
+        class quotient_set_iterator {
+            friend class quotient_set;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = TKey;
+            using difference_type = std::ptrdiff_t;
+            using reference = TKey;
+            using pointer = void;
+
+        private:
+            const quotient_set *set_{nullptr};
+            size_type index_{0};
+
+            quotient_set_iterator(const quotient_set *set, size_type index)
+                    : set_(set), index_(index) {
+                skip_empty();
+            }
+
+            void skip_empty() {
+                while (index_ < set_->_capacity() && set_->_load(index_) == 0) {
+                    ++index_;
+                }
+            }
+
+        public:
+            quotient_set_iterator() = default;
+
+            reference operator*() const {
+                return static_cast<TKey>(_unmix(set_->_mixed_at(index_, set_->_load(index_))));
+            }
+
+            bool operator==(const quotient_set_iterator &other) const {
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const quotient_set_iterator &other) const {
+                return index_ != other.index_;
+            }
+
+            quotient_set_iterator &operator++() {
+                ++index_;
+                skip_empty();
+                return *this;
+            }
+
+            quotient_set_iterator operator++(int) {
+                quotient_set_iterator result = *this;
+                ++(*this);
+                return result;
+            }
+        };
+    };
 
     template<class TKey,
             class TValue,
@@ -2357,5 +6305,52 @@ namespace ld {
             class KeyEqual = std::equal_to<TKey>,
             class Allocator = std::allocator<TKey>>
     using unordered_prime_set = unordered_set<TKey, KeyHash, KeyEqual, Allocator, prime_growth_policy>;
+
+    template<class TKey,
+            class TValue,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>>
+    using unordered_fastrange_map = unordered_map<TKey, TValue, KeyHash, KeyEqual, Allocator, fastrange_growth_policy<>>;
+
+    template<class TKey,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<TKey>>
+    using unordered_fastrange_set = unordered_set<TKey, KeyHash, KeyEqual, Allocator, fastrange_growth_policy<>>;
+
+    template<class TKey,
+            class TValue,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>>
+    using stable_unordered_map = unordered_map<TKey, TValue, KeyHash, KeyEqual, Allocator, power_of_two_growth_policy,
+            no_instrumentation, stable_storage>;
+
+    template<class TKey,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<TKey>>
+    using stable_unordered_set = unordered_set<TKey, KeyHash, KeyEqual, Allocator, power_of_two_growth_policy,
+            no_instrumentation, stable_storage>;
+
+    template<class TKey,
+            class TValue,
+            class KeyHash = std::hash<TKey>,
+            class KeyEqual = std::equal_to<TKey>,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>>
+    using split_unordered_map = unordered_map<TKey, TValue, KeyHash, KeyEqual, Allocator, power_of_two_growth_policy,
+            no_instrumentation, split_storage>;
+
+    template<class TKey,
+            class TValue,
+            class Allocator = std::allocator<std::pair<const TKey, TValue>>>
+    using byte_key_map = unordered_map<TKey, TValue, byte_key_hash<TKey>, byte_key_equal<TKey>, Allocator,
+            power_of_two_growth_policy, no_instrumentation, hashless_storage<byte_key_hash<TKey>>>;
+
+    template<class TKey,
+            class Allocator = std::allocator<TKey>>
+    using byte_key_set = unordered_set<TKey, byte_key_hash<TKey>, byte_key_equal<TKey>, Allocator,
+            power_of_two_growth_policy, no_instrumentation, hashless_storage<byte_key_hash<TKey>>>;
 }
-#endif //HASHMAP_ROBIN_HOOD_H
\ No newline at end of file
+#endif //HASHMAP_ROBIN_HOOD_H
\ No newline at end of file